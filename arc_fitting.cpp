@@ -0,0 +1,155 @@
+#include <cmath>
+
+#include "geometry.hpp"
+#include "arc_fitting.hpp"
+
+namespace arc_fitting {
+
+using std::vector;
+
+// True if all the points from path[first] to path[last] are within tolerance
+// of the line between the two.
+static bool is_straight(const linestring_type_fp& path,
+                        size_t first, size_t last, double tolerance) {
+  const segment_type_fp chord(path[first], path[last]);
+  for (size_t i = first + 1; i < last; i++) {
+    if (bg::distance(path[i], chord) > tolerance) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Arcs need at least this many segments, otherwise they don't save anything.
+static const size_t min_arc_segments = 3;
+// When a longer run doesn't fit the arc so far, a new arc is fitted to the
+// whole run.  Stop doing that once it has checked this many times as many
+// points as are in the run, so that the run time stays linear.
+static const size_t max_refit_work = 4;
+
+// The center of the circle through a, b and c, if there is one.
+static boost::optional<point_type_fp> circumcenter(const point_type_fp& a,
+                                                   const point_type_fp& b,
+                                                   const point_type_fp& c) {
+  const double d = 2 * (a.x() * (b.y() - c.y()) +
+                        b.x() * (c.y() - a.y()) +
+                        c.x() * (a.y() - b.y()));
+  if (d == 0) {
+    return boost::none;
+  }
+  const double a2 = a.x() * a.x() + a.y() * a.y();
+  const double b2 = b.x() * b.x() + b.y() * b.y();
+  const double c2 = c.x() * c.x() + c.y() * c.y();
+  return point_type_fp((a2 * (b.y() - c.y()) + b2 * (c.y() - a.y()) + c2 * (a.y() - b.y())) / d,
+                       (a2 * (c.x() - b.x()) + b2 * (a.x() - c.x()) + c2 * (b.x() - a.x())) / d);
+}
+
+// An arc around center that the path has followed so far.
+struct Arc {
+  point_type_fp center;
+  double radius;
+  boost::optional<bool> clockwise;
+  double sweep;
+};
+
+// If the segment from start to end stays within tolerance of the arc and
+// turns the same way, extend the arc along it and return true.  Otherwise
+// the arc is unchanged.
+static bool extend_arc(Arc& arc, const point_type_fp& start, const point_type_fp& end,
+                       double tolerance) {
+  const auto& center = arc.center;
+  if (std::abs(bg::distance(center, end) - arc.radius) > tolerance) {
+    return false;
+  }
+  // The chord between consecutive points is inside the circle.
+  const point_type_fp middle((start.x() + end.x()) / 2, (start.y() + end.y()) / 2);
+  if (arc.radius - bg::distance(center, middle) > tolerance) {
+    return false;
+  }
+  // All the segments must turn in the same direction around the center.
+  const double cross = (start.x() - center.x()) * (end.y() - center.y()) -
+                       (start.y() - center.y()) * (end.x() - center.x());
+  const double dot = (start.x() - center.x()) * (end.x() - center.x()) +
+                     (start.y() - center.y()) * (end.y() - center.y());
+  if (cross == 0 || (arc.clockwise && *arc.clockwise != (cross < 0))) {
+    return false;
+  }
+  const double sweep = arc.sweep + std::atan2(std::abs(cross), dot);
+  // A full circle would have the same start and end, which isn't an arc.
+  if (sweep >= 2 * bg::math::pi<double>() - 0.01) {
+    return false;
+  }
+  arc.clockwise = cross < 0;
+  arc.sweep = sweep;
+  return true;
+}
+
+// If path[first] to path[last] can be replaced by an arc without moving more
+// than tolerance away from the path, return the arc.
+static boost::optional<Arc> fit_arc(const linestring_type_fp& path,
+                                    size_t first, size_t last, double tolerance) {
+  const auto center = circumcenter(path[first], path[(first + last) / 2], path[last]);
+  if (!center) {
+    return boost::none;
+  }
+  Arc arc{*center, bg::distance(*center, path[first]), boost::none, 0};
+  if (arc.radius <= tolerance) {
+    return boost::none;
+  }
+  for (size_t i = first; i < last; i++) {
+    if (!extend_arc(arc, path[i], path[i + 1], tolerance)) {
+      return boost::none;
+    }
+  }
+  return arc;
+}
+
+vector<Move> fit_arcs(const linestring_type_fp& path, double tolerance) {
+  vector<Move> moves;
+  size_t current = 0;
+  while (current + 1 < path.size()) {
+    boost::optional<Arc> arc;
+    size_t last = current + min_arc_segments;
+    if (last < path.size()) {
+      arc = fit_arc(path, current, last, tolerance);
+    }
+    if (arc) {
+      // Extend the arc for as long as it still fits, checking only the new
+      // segment each time.
+      size_t refit_work = 0;
+      while (last + 1 < path.size()) {
+        if (extend_arc(*arc, path[last], path[last + 1], tolerance)) {
+          last++;
+          continue;
+        }
+        // A circle through more of the run might fit better.
+        if (refit_work > max_refit_work * (last - current)) {
+          break;
+        }
+        refit_work += last + 1 - current;
+        const auto refit = fit_arc(path, current, last + 1, tolerance);
+        if (!refit) {
+          break;
+        }
+        arc = refit;
+        last++;
+      }
+    }
+    if (arc && !is_straight(path, current, last, tolerance)) {
+      moves.push_back(Move{path[last], arc->center, *arc->clockwise});
+    } else {
+      // Either no arc fits or the arc is so flat that it might as well be
+      // the original lines.
+      if (!arc) {
+        last = current + 1;
+      }
+      for (size_t i = current + 1; i <= last; i++) {
+        moves.push_back(Move{path[i], boost::none, false});
+      }
+    }
+    current = last;
+  }
+  return moves;
+}
+
+} // namespace arc_fitting
@@ -0,0 +1,28 @@
+#ifndef ARC_FITTING_HPP
+#define ARC_FITTING_HPP
+
+#include <vector>
+
+#include <boost/optional.hpp>
+
+#include "geometry.hpp"
+
+namespace arc_fitting {
+
+// One move of the tool, starting from wherever the previous move ended.  If
+// center is set then the move is along an arc around center, otherwise it's a
+// straight line.
+struct Move {
+  point_type_fp end;
+  boost::optional<point_type_fp> center;
+  bool clockwise;
+};
+
+// Convert a path into moves.  Runs of short segments that all lie within
+// tolerance of a circle are replaced by a single arc.  The first point of the
+// path isn't in the output because that's where the tool starts.
+std::vector<Move> fit_arcs(const linestring_type_fp& path, double tolerance);
+
+} // namespace arc_fitting
+
+#endif // ARC_FITTING_HPP
@@ -0,0 +1,102 @@
+#define BOOST_TEST_MODULE arc fitting tests
+#include <boost/test/unit_test.hpp>
+
+#include "geometry.hpp"
+#include "bg_operators.hpp"
+#include "arc_fitting.hpp"
+
+using arc_fitting::fit_arcs;
+
+BOOST_AUTO_TEST_SUITE(arc_fitting_tests)
+
+// Points on a circle from start_angle to end_angle, in radians.
+static linestring_type_fp circle_points(point_type_fp center, double radius,
+                                        double start_angle, double end_angle, size_t segments) {
+  linestring_type_fp ret;
+  for (size_t i = 0; i <= segments; i++) {
+    const double angle = start_angle + (end_angle - start_angle) * i / segments;
+    ret.push_back(point_type_fp(center.x() + radius * cos(angle),
+                                center.y() + radius * sin(angle)));
+  }
+  return ret;
+}
+
+BOOST_AUTO_TEST_CASE(empty) {
+  BOOST_CHECK_EQUAL(fit_arcs(linestring_type_fp(), 0.001).size(), 0UL);
+  BOOST_CHECK_EQUAL(fit_arcs(linestring_type_fp{{1, 1}}, 0.001).size(), 0UL);
+}
+
+BOOST_AUTO_TEST_CASE(straight) {
+  linestring_type_fp path{{0, 0}, {1, 0}, {2, 0}, {3, 0}, {3, 1}, {3, 2}};
+  const auto moves = fit_arcs(path, 0.001);
+  BOOST_REQUIRE_EQUAL(moves.size(), 5UL);
+  for (size_t i = 0; i < moves.size(); i++) {
+    BOOST_CHECK(!moves[i].center);
+    BOOST_CHECK_EQUAL(moves[i].end, path[i + 1]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(quarter_circle) {
+  const auto path = circle_points({1, 2}, 3, 0, bg::math::pi<double>() / 2, 20);
+  // The segments are up to 0.0024 from the circle.
+  BOOST_CHECK_EQUAL(fit_arcs(path, 0.001).size(), 20UL);
+  const auto moves = fit_arcs(path, 0.003);
+  BOOST_REQUIRE_EQUAL(moves.size(), 1UL);
+  BOOST_REQUIRE(moves[0].center);
+  BOOST_CHECK_SMALL(bg::distance(*moves[0].center, point_type_fp(1, 2)), 1e-9);
+  BOOST_CHECK(!moves[0].clockwise);
+  BOOST_CHECK_EQUAL(moves[0].end, path.back());
+}
+
+BOOST_AUTO_TEST_CASE(clockwise) {
+  const auto path = circle_points({0, 0}, 1, 1, -1, 10);
+  const auto moves = fit_arcs(path, 0.01);
+  BOOST_REQUIRE_EQUAL(moves.size(), 1UL);
+  BOOST_CHECK(moves[0].clockwise);
+}
+
+BOOST_AUTO_TEST_CASE(long_arc) {
+  // Many more points than would be practical to refit each time.
+  const auto path = circle_points({0, 0}, 10, 0, bg::math::pi<double>(), 100000);
+  const auto moves = fit_arcs(path, 0.0001);
+  BOOST_REQUIRE_EQUAL(moves.size(), 1UL);
+  BOOST_CHECK_EQUAL(moves[0].end, path.back());
+}
+
+BOOST_AUTO_TEST_CASE(full_circle) {
+  // Can't be a single arc because the start and end are the same.
+  const auto path = circle_points({0, 0}, 1, 0, 2 * bg::math::pi<double>(), 36);
+  const auto moves = fit_arcs(path, 0.01);
+  BOOST_REQUIRE_EQUAL(moves.size(), 2UL);
+  BOOST_CHECK(moves[0].center);
+  BOOST_CHECK_EQUAL(moves[1].end, path.back());
+}
+
+BOOST_AUTO_TEST_CASE(line_arc_line) {
+  linestring_type_fp path{{-2, 1}, {-1, 1}};
+  const auto arc = circle_points({0, 0}, 1, bg::math::pi<double>() / 2, 0, 12);
+  path.insert(path.end(), arc.cbegin(), arc.cend());
+  path.push_back(point_type_fp(1, -1));
+  path.push_back(point_type_fp(1, -2));
+  const auto moves = fit_arcs(path, 0.003);
+  BOOST_REQUIRE_EQUAL(moves.size(), 5UL);
+  BOOST_CHECK(!moves[0].center);
+  BOOST_CHECK(!moves[1].center);
+  BOOST_CHECK(moves[2].center);
+  BOOST_CHECK(moves[2].clockwise);
+  BOOST_CHECK_SMALL(bg::distance(moves[2].end, point_type_fp(1, 0)), 1e-9);
+  BOOST_CHECK(!moves[3].center);
+  BOOST_CHECK(!moves[4].center);
+}
+
+BOOST_AUTO_TEST_CASE(not_quite_a_circle) {
+  // A polygon with wobbly corners doesn't fit within the tolerance.
+  auto path = circle_points({0, 0}, 1, 0, 1, 10);
+  for (size_t i = 0; i < path.size(); i += 2) {
+    path[i].x(path[i].x() * 1.01);
+  }
+  BOOST_CHECK_EQUAL(fit_arcs(path, 0.0001).size(), 10UL);
+  BOOST_CHECK_EQUAL(fit_arcs(path, 0.1).size(), 1UL);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
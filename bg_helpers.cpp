@@ -1,3 +1,8 @@
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
 #include "eulerian_paths.hpp"
 #ifdef GEOS_VERSION
 #include <geos/operation/buffer/BufferOp.h>
@@ -7,19 +12,139 @@
 #include "bg_operators.hpp"
 #include "bg_helpers.hpp"
 #include "common.hpp"
+#include "precision.hpp"
+#include "stats.hpp"
 
 namespace bg_helpers {
 
+// The same shapes are often buffered by the same distance many times, for
+// keep-outs, for path minimums and for finding contentions.  This remembers
+// the most recently used results, up to a limit on the total number of
+// coordinates stored.  The key is all the input coordinates, along with the
+// sizes of the rings and linestrings, the distance, the kind of buffer and
+// the precision, which sets the number of points on the round joins.
+class BufferCache {
+ public:
+  BufferCache(size_t max_size) : max_size(max_size) {}
+  void enable(bool enabled) {
+    std::lock_guard<std::mutex> lock(mutex);
+    enabled_ = enabled;
+    if (!enabled) {
+      entries.clear();
+      index.clear();
+      total_size = 0;
+    }
+  }
+  template <typename Compute>
+  multi_polygon_type_fp get(std::vector<double> key, Compute compute) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!enabled_) {
+        return compute();
+      }
+    }
+    const auto hash = std::hash<std::vector<double>>{}(key);
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      const auto found = index.find(hash);
+      if (found != index.cend() && found->second->key == key) {
+        entries.splice(entries.begin(), entries, found->second);
+        stats::add("buffer cache hits", 1);
+        return found->second->value;
+      }
+    }
+    stats::add("buffer cache misses", 1);
+    auto value = compute();
+    const size_t size = key.size() + bg::num_points(value) * 2;
+    if (size > max_size / 2) {
+      return value;  // Not worth pushing out everything else.
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto found = index.find(hash);
+    if (found != index.cend()) {
+      // Either another thread got here first or it's a hash collision.
+      remove(found->second);
+    }
+    entries.push_front(Entry{std::move(key), value, size});
+    index[hash] = entries.begin();
+    total_size += size;
+    while (total_size > max_size) {
+      remove(std::prev(entries.end()));
+    }
+    return value;
+  }
+
+ private:
+  struct Entry {
+    std::vector<double> key;
+    multi_polygon_type_fp value;
+    size_t size;
+  };
+
+  void remove(std::list<Entry>::iterator entry) {
+    total_size -= entry->size;
+    index.erase(std::hash<std::vector<double>>{}(entry->key));
+    entries.erase(entry);
+  }
+
+  std::list<Entry> entries;  // Most recently used first.
+  std::unordered_map<size_t, std::list<Entry>::iterator> index;
+  size_t total_size = 0;
+  const size_t max_size;
+  bool enabled_ = true;
+  std::mutex mutex;
+};
+
+// About 64MB.
+static BufferCache buffer_cache(8 * 1024 * 1024);
+
+void enable_cache(bool enabled) {
+  buffer_cache.enable(enabled);
+}
+
+enum class BufferKind { ROUND_POLYGONS, MITER_POLYGONS, ROUND_LINESTRINGS };
+
+static void add_points(std::vector<double>& key, const std::vector<point_type_fp>& points) {
+  key.push_back(points.size());
+  for (const auto& point : points) {
+    key.push_back(point.x());
+    key.push_back(point.y());
+  }
+}
+
+static std::vector<double> buffer_key(BufferKind kind, coordinate_type_fp expand_by,
+                                      const multi_polygon_type_fp& geometry) {
+  std::vector<double> key{double(kind), expand_by, precision::get_max_deviation(),
+                          double(geometry.size())};
+  key.reserve(key.size() + bg::num_points(geometry) * 2 + geometry.size() * 2);
+  for (const auto& poly : geometry) {
+    add_points(key, poly.outer());
+    key.push_back(poly.inners().size());
+    for (const auto& inner : poly.inners()) {
+      add_points(key, inner);
+    }
+  }
+  return key;
+}
+
+static std::vector<double> buffer_key(BufferKind kind, coordinate_type_fp expand_by,
+                                      const multi_linestring_type_fp& geometry) {
+  std::vector<double> key{double(kind), expand_by, precision::get_max_deviation(),
+                          double(geometry.size())};
+  key.reserve(key.size() + bg::num_points(geometry) * 2 + geometry.size());
+  for (const auto& ls : geometry) {
+    add_points(key, ls);
+  }
+  return key;
+}
+
 // The below implementations of buffer are similar to bg::buffer but
 // always convert to floating-point before doing work, if needed, and
 // convert back afterward, if needed.  Also, they work if expand_by is
 // 0, unlike bg::buffer.
 
-multi_polygon_type_fp buffer(multi_polygon_type_fp const & geometry_in, coordinate_type_fp expand_by) {
-  if (expand_by == 0 || geometry_in.size() == 0) {
-    return geometry_in;
-  }
-  auto const points_per_circle = std::max(32., expand_by * 2 * bg::math::pi<double>() / 0.0004);
+static multi_polygon_type_fp buffer_uncached(multi_polygon_type_fp const & geometry_in, coordinate_type_fp expand_by) {
+  auto const points_per_circle = precision::points_per_circle(expand_by, 0.0004);
 #ifdef GEOS_VERSION
   auto geos_in = to_geos(geometry_in);
   return from_geos<multi_polygon_type_fp>(
@@ -37,19 +162,29 @@ multi_polygon_type_fp buffer(multi_polygon_type_fp const & geometry_in, coordina
 #endif
 }
 
+multi_polygon_type_fp buffer(multi_polygon_type_fp const & geometry_in, coordinate_type_fp expand_by) {
+  if (expand_by == 0 || geometry_in.size() == 0) {
+    return geometry_in;
+  }
+  return buffer_cache.get(buffer_key(BufferKind::ROUND_POLYGONS, expand_by, geometry_in),
+                          [&]() { return buffer_uncached(geometry_in, expand_by); });
+}
+
 multi_polygon_type_fp buffer_miter(multi_polygon_type_fp const & geometry_in, coordinate_type_fp expand_by) {
   if (expand_by == 0) {
     return geometry_in;
   } else {
-    multi_polygon_type_fp geometry_out;
-    auto const points_per_circle = std::max(32., expand_by * 2 * bg::math::pi<double>() / 0.0004);
-    bg::buffer(geometry_in, geometry_out,
-               bg::strategy::buffer::distance_symmetric<coordinate_type_fp>(expand_by),
-               bg::strategy::buffer::side_straight(),
-               bg::strategy::buffer::join_miter(expand_by),
-               bg::strategy::buffer::end_round(points_per_circle),
-               bg::strategy::buffer::point_circle(points_per_circle));
-    return geometry_out;
+    return buffer_cache.get(buffer_key(BufferKind::MITER_POLYGONS, expand_by, geometry_in), [&]() {
+      multi_polygon_type_fp geometry_out;
+      auto const points_per_circle = precision::points_per_circle(expand_by, 0.0004);
+      bg::buffer(geometry_in, geometry_out,
+                 bg::strategy::buffer::distance_symmetric<coordinate_type_fp>(expand_by),
+                 bg::strategy::buffer::side_straight(),
+                 bg::strategy::buffer::join_miter(expand_by),
+                 bg::strategy::buffer::end_round(points_per_circle),
+                 bg::strategy::buffer::point_circle(points_per_circle));
+      return geometry_out;
+    });
   }
 }
 
@@ -70,7 +205,7 @@ multi_polygon_type_fp buffer(linestring_type_fp const & geometry_in, CoordinateT
   if (expand_by == 0) {
     return {};
   }
-  auto const points_per_circle = std::max(32., expand_by * 2 * bg::math::pi<double>() / 0.0004);
+  auto const points_per_circle = precision::points_per_circle(expand_by, 0.0004);
 #ifdef GEOS_VERSION
   auto geos_in = to_geos(geometry_in);
   return from_geos<multi_polygon_type_fp>(
@@ -88,24 +223,17 @@ multi_polygon_type_fp buffer(linestring_type_fp const & geometry_in, CoordinateT
 #endif
 }
 
-template<typename CoordinateType>
-multi_polygon_type_fp buffer(multi_linestring_type_fp const & geometry_in, CoordinateType expand_by) {
-  if (expand_by == 0 || geometry_in.size() == 0) {
-    return {};
-  }
+static multi_polygon_type_fp buffer_uncached(multi_linestring_type_fp const & geometry_in, coordinate_type_fp expand_by) {
   // bg::buffer of multilinestring is broken in boost.  Converting the
   // multilinestring to non-intersecting paths seems to help.
   multi_linestring_type_fp mls = eulerian_paths::make_eulerian_paths(geometry_in, true, true);
 #ifdef GEOS_VERSION
-  auto const points_per_circle = std::max(32., expand_by * 2 * bg::math::pi<double>() / 0.0004);
+  auto const points_per_circle = precision::points_per_circle(expand_by, 0.0004);
   auto geos_in = to_geos(mls);
   return from_geos<multi_polygon_type_fp>(
       std::unique_ptr<geos::geom::Geometry>(
           geos::operation::buffer::BufferOp::bufferOp(geos_in.get(), expand_by, points_per_circle/4)));
 #else
-  if (expand_by == 0) {
-    return {};
-  }
   multi_polygon_type_fp ret;
   for (const auto& ls : mls) {
     ret = ret + buffer(ls, expand_by);
@@ -114,6 +242,15 @@ multi_polygon_type_fp buffer(multi_linestring_type_fp const & geometry_in, Coord
 #endif
 }
 
+template<typename CoordinateType>
+multi_polygon_type_fp buffer(multi_linestring_type_fp const & geometry_in, CoordinateType expand_by) {
+  if (expand_by == 0 || geometry_in.size() == 0) {
+    return {};
+  }
+  return buffer_cache.get(buffer_key(BufferKind::ROUND_LINESTRINGS, expand_by, geometry_in),
+                          [&]() { return buffer_uncached(geometry_in, expand_by); });
+}
+
 template multi_polygon_type_fp buffer(const multi_linestring_type_fp&, double expand_by);
 
 template<typename CoordinateType>
@@ -6,6 +6,10 @@
 
 namespace bg_helpers {
 
+// buffer and buffer_miter remember their recent results.  Turning that off
+// forgets them too, so that buffering can be timed.  On by default.
+void enable_cache(bool enabled);
+
 // The below implementations of buffer are similar to bg::buffer but
 // always convert to floating-point before doing work, if needed, and
 // convert back afterward, if needed.  Also, they work if expand_by is
@@ -0,0 +1,76 @@
+#define BOOST_TEST_MODULE bg_helpers tests
+#include <boost/test/unit_test.hpp>
+
+#include <sstream>
+#include <string>
+
+#include "geometry.hpp"
+#include "bg_operators.hpp"
+#include "bg_helpers.hpp"
+#include "precision.hpp"
+#include "stats.hpp"
+
+using bg_helpers::buffer;
+using bg_helpers::buffer_miter;
+
+BOOST_AUTO_TEST_SUITE(bg_helpers_tests)
+
+// The value of one counter in the stats, or 0 if it hasn't been added to.
+static size_t counter(const std::string& name) {
+  std::ostringstream report;
+  stats::report(report);
+  std::istringstream lines(report.str());
+  std::string line;
+  while (std::getline(lines, line)) {
+    if (line.compare(0, name.size() + 2, name + ": ") == 0) {
+      return std::stoul(line.substr(name.size() + 2));
+    }
+  }
+  return 0;
+}
+
+BOOST_AUTO_TEST_CASE(cached_buffer) {
+  stats::enable(true);
+  polygon_type_fp square;
+  bg::convert(box_type_fp{{0, 0}, {1, 1}}, square);
+  const auto first = buffer(square, 0.1);
+  const auto second = buffer(square, 0.1);
+  BOOST_CHECK_EQUAL(bg::num_points(first), bg::num_points(second));
+  BOOST_CHECK(bg::equals(first, second));
+  // Different distances and joins aren't mixed up.
+  BOOST_CHECK_GT(bg::area(buffer(square, 0.2)), bg::area(first));
+  BOOST_CHECK_NE(bg::area(buffer_miter(multi_polygon_type_fp{square}, 0.1)), bg::area(first));
+  multi_linestring_type_fp lines{{{0, 0}, {1, 0}}};
+  BOOST_CHECK_CLOSE(bg::area(buffer(lines, 0.1)), bg::area(buffer(lines, 0.1)), 1e-9);
+  BOOST_CHECK_EQUAL(counter("buffer cache misses"), 4UL);
+  BOOST_CHECK_EQUAL(counter("buffer cache hits"), 2UL);
+  // A different precision gives a different buffer.
+  precision::set_max_deviation(0.01);
+  const auto coarse = buffer(square, 0.1);
+  precision::set_max_deviation(0);
+  BOOST_CHECK_LT(bg::num_points(coarse), bg::num_points(first));
+  BOOST_CHECK_EQUAL(counter("buffer cache misses"), 5UL);
+  BOOST_CHECK_EQUAL(counter("buffer cache hits"), 2UL);
+  stats::enable(false);
+}
+
+BOOST_AUTO_TEST_CASE(uncached_buffer) {
+  polygon_type_fp square;
+  bg::convert(box_type_fp{{0, 0}, {1, 1}}, square);
+  const auto cached = buffer(square, 0.3);
+  bg_helpers::enable_cache(false);
+  stats::enable(true);
+  const size_t misses = counter("buffer cache misses");
+  const size_t hits = counter("buffer cache hits");
+  const auto first = buffer(square, 0.3);
+  const auto second = buffer(square, 0.3);
+  BOOST_CHECK(bg::equals(first, cached));
+  BOOST_CHECK(bg::equals(second, cached));
+  // Neither a hit nor a miss.
+  BOOST_CHECK_EQUAL(counter("buffer cache misses"), misses);
+  BOOST_CHECK_EQUAL(counter("buffer cache hits"), hits);
+  stats::enable(false);
+  bg_helpers::enable_cache(true);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -8,6 +8,13 @@
 #endif // GEOS_VERSION
 
 #include "bg_operators.hpp"
+#include "disjoint_set.hpp"
+
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <boost/geometry/index/rtree.hpp>
+#include <boost/optional.hpp>
 
 using std::unique_ptr;
 using std::vector;
@@ -272,16 +279,150 @@ multi_polygon_type_fp sum(const std::vector<multi_polygon_type_fp>& mpolys) {
 #endif // GEOS_VERSION
 }
 
+// Make a polygon from a ring, with the orientation that bg expects.
+static polygon_type_fp ring_to_polygon(const ring_type_fp& ring) {
+  polygon_type_fp poly;
+  poly.outer() = ring;
+  bg::correct(poly);
+  return poly;
+}
+
+// Even-odd fill of rings whose boundaries don't touch each other.  A ring
+// nested inside an even number of other rings becomes the outer of a
+// polygon and a ring nested inside an odd number of rings becomes a hole
+// in the polygon of the ring that immediately encloses it.  neighbors has,
+// for each ring, the rings whose bounding boxes intersect it.
+static multi_polygon_type_fp even_odd_fill(const vector<ring_type_fp>& rings,
+                                           const vector<box_type_fp>& bboxes,
+                                           const vector<double>& areas,
+                                           const vector<vector<size_t>>& neighbors,
+                                           const vector<size_t>& cluster) {
+  // Sort from largest to smallest so that each ring's parent comes before it.
+  auto sorted = cluster;
+  std::sort(sorted.begin(), sorted.end(),
+            [&areas](size_t a, size_t b) { return areas[a] > areas[b]; });
+  std::unordered_map<size_t, size_t> rank;
+  for (size_t i = 0; i < sorted.size(); i++) {
+    rank[sorted[i]] = i;
+  }
+  multi_polygon_type_fp ret;
+  // For each ring, which polygon in ret it belongs to, as outer or inner.
+  std::unordered_map<size_t, size_t> ring_to_output;
+  std::unordered_map<size_t, size_t> depth;
+  for (const auto& current : sorted) {
+    // The parent is the smallest ring that encloses this one.  Rings don't
+    // cross so checking one point is enough.
+    boost::optional<size_t> parent;
+    for (const auto& candidate : neighbors[current]) {
+      if (rank.at(candidate) >= rank.at(current) ||
+          (parent && areas[candidate] >= areas[*parent])) {
+        continue;
+      }
+      if (bg::covered_by(bboxes[current], bboxes[candidate]) &&
+          bg::within(rings[current].front(), rings[candidate])) {
+        parent = candidate;
+      }
+    }
+    depth[current] = parent ? depth.at(*parent) + 1 : 0;
+    if (depth[current] % 2 == 0) {
+      ring_to_output[current] = ret.size();
+      ret.push_back(ring_to_polygon(rings[current]));
+    } else {
+      const auto output_index = ring_to_output.at(*parent);
+      ring_to_output[current] = output_index;
+      ret[output_index].inners().push_back(rings[current]);
+    }
+  }
+  bg::correct(ret);
+  return ret;
+}
+
+// The exclusive or of all the inputs.  Each input is split into its rings,
+// because xor-ing all the rings is the same as xor-ing the inputs.  Rings
+// that have intersecting bounding boxes are clustered.  Clusters of one ring
+// are copied to the output, clusters where no boundaries touch are filled
+// with the even-odd rule in one pass and only the rest are xor-ed pairwise.
 multi_polygon_type_fp symdiff(const std::vector<multi_polygon_type_fp>& mpolys) {
   if (mpolys.size() == 0) {
     return multi_polygon_type_fp();
   } else if (mpolys.size() == 1) {
     return mpolys[0];
   }
-  std::vector<box_type_fp> bboxes;
-  bboxes.reserve(mpolys.size());
+  vector<ring_type_fp> rings;
   for (const auto& mpoly : mpolys) {
-    bboxes.push_back(bg::return_envelope<box_type_fp>(mpoly));
+    for (const auto& poly : mpoly) {
+      rings.push_back(poly.outer());
+      rings.insert(rings.cend(), poly.inners().cbegin(), poly.inners().cend());
+    }
   }
-  return reduce(mpolys, operator^<polygon_type_fp>);
+  vector<box_type_fp> bboxes;
+  vector<double> areas;
+  bboxes.reserve(rings.size());
+  areas.reserve(rings.size());
+  vector<std::pair<box_type_fp, size_t>> indexed_bboxes;
+  for (const auto& ring : rings) {
+    areas.push_back(std::abs(bg::area(ring)));
+    if (areas.back() == 0) {
+      // Nothing to xor, an empty box won't intersect anything.
+      bboxes.push_back(box_type_fp{{INFINITY, INFINITY}, {-INFINITY, -INFINITY}});
+      continue;
+    }
+    bboxes.push_back(bg::return_envelope<box_type_fp>(ring));
+    indexed_bboxes.emplace_back(bboxes.back(), bboxes.size() - 1);
+  }
+  bg::index::rtree<std::pair<box_type_fp, size_t>, bg::index::rstar<16>> tree(indexed_bboxes);
+
+  vector<vector<size_t>> neighbors(rings.size());
+  DisjointSet<size_t> clusters;
+  vector<size_t> crossings;
+  for (const auto& indexed_bbox : indexed_bboxes) {
+    const auto& i = indexed_bbox.second;
+    clusters.find(i);
+    vector<std::pair<box_type_fp, size_t>> overlaps;
+    tree.query(bg::index::intersects(bboxes[i]), std::back_inserter(overlaps));
+    for (const auto& overlap : overlaps) {
+      const auto& j = overlap.second;
+      if (j == i) {
+        continue;
+      }
+      neighbors[i].push_back(j);
+      if (j < i) {
+        continue; // Only check each pair once.
+      }
+      clusters.join(i, j);
+      if (bg::intersects(linestring_type_fp(rings[i].cbegin(), rings[i].cend()),
+                         linestring_type_fp(rings[j].cbegin(), rings[j].cend()))) {
+        crossings.push_back(i);
+      }
+    }
+  }
+
+  std::map<size_t, vector<size_t>> cluster_members;
+  for (const auto& indexed_bbox : indexed_bboxes) {
+    cluster_members[clusters.find(indexed_bbox.second)].push_back(indexed_bbox.second);
+  }
+  std::set<size_t> crossing_clusters;
+  for (const auto& crossing : crossings) {
+    crossing_clusters.insert(clusters.find(crossing));
+  }
+
+  multi_polygon_type_fp ret;
+  for (const auto& cluster : cluster_members) {
+    const auto& members = cluster.second;
+    multi_polygon_type_fp filled;
+    if (members.size() == 1) {
+      filled.push_back(ring_to_polygon(rings[members.front()]));
+    } else if (crossing_clusters.count(cluster.first) == 0) {
+      filled = even_odd_fill(rings, bboxes, areas, neighbors, members);
+    } else {
+      vector<multi_polygon_type_fp> cluster_mpolys;
+      cluster_mpolys.reserve(members.size());
+      for (const auto& member : members) {
+        cluster_mpolys.push_back({ring_to_polygon(rings[member])});
+      }
+      filled = reduce(cluster_mpolys, operator^<polygon_type_fp>);
+    }
+    ret.insert(ret.cend(), filled.cbegin(), filled.cend());
+  }
+  return ret;
 }
@@ -0,0 +1,62 @@
+#define BOOST_TEST_MODULE bg operators tests
+#include <boost/test/unit_test.hpp>
+
+#include "geometry.hpp"
+#include "bg_operators.hpp"
+#include "test_shapes.hpp"
+
+BOOST_AUTO_TEST_SUITE(bg_operators_tests)
+
+// The result of xor-ing each one in turn.
+static multi_polygon_type_fp pairwise_symdiff(const std::vector<multi_polygon_type_fp>& mpolys) {
+  multi_polygon_type_fp ret;
+  for (const auto& mpoly : mpolys) {
+    ret = ret ^ mpoly;
+  }
+  return ret;
+}
+
+static void check_symdiff(const std::vector<multi_polygon_type_fp>& mpolys) {
+  const auto result = symdiff(mpolys);
+  const auto expected = pairwise_symdiff(mpolys);
+  BOOST_CHECK(bg::is_valid(result));
+  // Boost.Geometry's xor can move the points where boundaries cross by about
+  // 1e-7, differently for each order of xor-ing.
+  BOOST_CHECK_CLOSE(bg::area(result), bg::area(expected), 1e-4);
+  BOOST_CHECK_SMALL(bg::area(result ^ expected), 1e-9);
+}
+
+BOOST_AUTO_TEST_CASE(symdiff_empty) {
+  BOOST_CHECK_EQUAL(symdiff({}).size(), 0UL);
+  BOOST_CHECK(bg::equals(symdiff({square(0, 0, 1)}), square(0, 0, 1)));
+}
+
+BOOST_AUTO_TEST_CASE(symdiff_disjoint) {
+  check_symdiff({square(0, 0, 1), square(2, 0, 1), square(0, 2, 1)});
+  BOOST_CHECK_EQUAL(symdiff({square(0, 0, 1), square(2, 0, 1), square(0, 2, 1)}).size(), 3UL);
+}
+
+BOOST_AUTO_TEST_CASE(symdiff_nested) {
+  // An outline with cutouts, one of which has an island inside it.
+  std::vector<multi_polygon_type_fp> mpolys{
+    square(2, 2, 1), square(0, 0, 10), square(5, 5, 4), square(6, 6, 2), square(6.5, 6.5, 1)};
+  check_symdiff(mpolys);
+  const auto result = symdiff(mpolys);
+  BOOST_CHECK_EQUAL(result.size(), 2UL);
+  BOOST_CHECK_CLOSE(bg::area(result), 100 - 1 - 16 + 4 - 1, 1e-9);
+}
+
+BOOST_AUTO_TEST_CASE(symdiff_with_holes) {
+  // An input with a hole is the same as xor-ing its rings.
+  auto outline_with_hole = square(0, 0, 10) - square(1, 1, 8);
+  check_symdiff({outline_with_hole, square(2, 2, 6), square(3, 3, 1)});
+}
+
+BOOST_AUTO_TEST_CASE(symdiff_crossing) {
+  // Overlapping boundaries need the pairwise fallback.
+  check_symdiff({square(0, 0, 2), square(1, 1, 2), square(1.5, 0, 2), square(10, 10, 1)});
+  // Touching boundaries, too.
+  check_symdiff({square(0, 0, 2), square(2, 0, 2), square(0, 0, 1)});
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,99 @@
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+#include "debug_output.hpp"
+
+namespace debug_output {
+
+static DebugOutput::DebugOutput current_level = DebugOutput::FULL;
+
+void set_level(DebugOutput::DebugOutput level) {
+  current_level = level;
+}
+
+bool images() {
+  return current_level == DebugOutput::FULL;
+}
+
+bool contentions() {
+  return current_level != DebugOutput::NONE;
+}
+
+// A single thread that runs the jobs in order.  It's started with the first
+// job and, on exit, runs the jobs that are left before stopping.
+class Writer {
+ public:
+  ~Writer() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    job_added.notify_one();
+    if (thread.joinable()) {
+      thread.join();
+    }
+  }
+
+  void add(std::function<void()> job) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      jobs.push_back(std::move(job));
+      if (!thread.joinable()) {
+        thread = std::thread(&Writer::run, this);
+      }
+    }
+    job_added.notify_one();
+  }
+
+  void finish() {
+    std::unique_lock<std::mutex> lock(mutex);
+    jobs_done.wait(lock, [this]() { return jobs.empty() && !busy; });
+  }
+
+ private:
+  void run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      job_added.wait(lock, [this]() { return stopping || !jobs.empty(); });
+      if (jobs.empty()) {
+        return;  // Stopping and nothing left to do.
+      }
+      auto job = std::move(jobs.front());
+      jobs.pop_front();
+      busy = true;
+      lock.unlock();
+      try {
+        job();
+      } catch (const std::exception& e) {
+        std::cerr << "Warning: failed to write debugging output: " << e.what() << std::endl;
+      }
+      lock.lock();
+      busy = false;
+      jobs_done.notify_all();
+    }
+  }
+
+  std::deque<std::function<void()>> jobs;
+  bool busy = false;
+  bool stopping = false;
+  std::mutex mutex;
+  std::condition_variable job_added;
+  std::condition_variable jobs_done;
+  std::thread thread;
+};
+
+static Writer writer;
+
+void write(std::function<void()> job) {
+  writer.add(std::move(job));
+}
+
+void finish() {
+  writer.finish();
+}
+
+} // namespace debug_output
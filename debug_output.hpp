@@ -0,0 +1,27 @@
+#ifndef DEBUG_OUTPUT_HPP
+#define DEBUG_OUTPUT_HPP
+
+#include <functional>
+
+#include "units.hpp"
+
+namespace debug_output {
+
+// How much debugging output to write.  The default is all of it.
+void set_level(DebugOutput::DebugOutput level);
+// Whether to write the SVG images of each stage of processing.
+bool images();
+// Whether to look for places where the tool can't keep its clearance from
+// the traces, warn about them and draw them.
+bool contentions();
+
+// Run the job on the background writer thread.  Jobs run one at a time, in
+// the order that they were added, so the job must own copies of everything
+// that it uses.
+void write(std::function<void()> job);
+// Wait for all the jobs so far to finish.
+void finish();
+
+} // namespace debug_output
+
+#endif // DEBUG_OUTPUT_HPP
@@ -0,0 +1,502 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <sys/stat.h>
+#include <sys/types.h>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <direct.h>
+#include <io.h>
+#include <sys/utime.h>
+#else
+#include <dirent.h>
+#include <utime.h>
+#endif
+
+#include <boost/format.hpp>
+
+#include "config.h"
+#include "disk_cache.hpp"
+#include "stats.hpp"
+
+namespace disk_cache {
+
+static std::string cache_directory;
+static uint64_t cache_max_size = 0;
+
+// Bump this when the layout of the files changes.
+static const uint32_t FORMAT_VERSION = 1;
+static const char MAGIC[8] = {'p', '2', 'g', 'c', 'a', 'c', 'h', 'e'};
+
+void set_directory(const std::string& directory, uint64_t max_size) {
+  cache_directory = directory;
+  cache_max_size = max_size;
+  if (!directory.empty()) {
+#ifdef _WIN32
+    _mkdir(directory.c_str());
+#else
+    mkdir(directory.c_str(), 0777);
+#endif
+  }
+}
+
+bool enabled() {
+  return !cache_directory.empty();
+}
+
+struct CacheFile {
+  std::string filename;
+  uint64_t size;
+  time_t modified;
+};
+
+// Only the files that look like they were written by save() so that nothing
+// else in the directory is ever removed.
+static bool is_cache_file(const std::string& name) {
+  return name.size() > 4 && name.compare(name.size() - 4, 4, ".bin") == 0;
+}
+
+static std::vector<CacheFile> cache_files() {
+  std::vector<CacheFile> files;
+#ifdef _WIN32
+  _finddata_t found;
+  const intptr_t handle = _findfirst((cache_directory + "/*.bin").c_str(), &found);
+  if (handle == -1) {
+    return files;
+  }
+  do {
+    if (!(found.attrib & _A_SUBDIR) && is_cache_file(found.name)) {
+      files.push_back({cache_directory + "/" + found.name, uint64_t(found.size), found.time_write});
+    }
+  } while (_findnext(handle, &found) == 0);
+  _findclose(handle);
+#else
+  DIR* dir = opendir(cache_directory.c_str());
+  if (dir == nullptr) {
+    return files;
+  }
+  while (const struct dirent* entry = readdir(dir)) {
+    const std::string filename = cache_directory + "/" + entry->d_name;
+    struct stat info;
+    if (is_cache_file(entry->d_name) && stat(filename.c_str(), &info) == 0 && S_ISREG(info.st_mode)) {
+      files.push_back({filename, uint64_t(info.st_size), info.st_mtime});
+    }
+  }
+  closedir(dir);
+#endif
+  return files;
+}
+
+void trim() {
+  if (!enabled() || cache_max_size == 0) {
+    return;
+  }
+  auto files = cache_files();
+  uint64_t total = 0;
+  for (const auto& file : files) {
+    total += file.size;
+  }
+  std::sort(files.begin(), files.end(), [](const CacheFile& a, const CacheFile& b) {
+    return a.modified < b.modified;
+  });
+  for (const auto& file : files) {
+    if (total <= cache_max_size) {
+      break;
+    }
+    if (std::remove(file.filename.c_str()) == 0) {
+      total -= file.size;
+      stats::add("disk cache files removed", 1);
+    }
+  }
+}
+
+// A file that is read is touched so that trim() keeps the files that are
+// still in use.
+static void touch(const std::string& filename) {
+#ifdef _WIN32
+  _utime(filename.c_str(), nullptr);
+#else
+  utime(filename.c_str(), nullptr);
+#endif
+}
+
+// FNV-1a, 64 bits.
+static const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+static const uint64_t FNV_PRIME = 1099511628211ULL;
+
+Key::Key(const std::string& kind, uint32_t version) : kind(kind), hash(FNV_OFFSET_BASIS) {
+  add(kind);
+  add(version);
+  add(PACKAGE_VERSION);
+#ifdef GIT_VERSION
+  add(GIT_VERSION);
+#endif
+  add(FORMAT_VERSION);
+}
+
+void Key::add_bytes(const void* bytes, size_t size) {
+  const unsigned char* data = static_cast<const unsigned char*>(bytes);
+  for (size_t i = 0; i < size; i++) {
+    hash ^= data[i];
+    hash *= FNV_PRIME;
+  }
+}
+
+Key& Key::add(const std::string& value) {
+  // The size first so that "ab","c" and "a","bc" are different.
+  add(value.size());
+  add_bytes(value.data(), value.size());
+  return *this;
+}
+
+Key& Key::add(double value) {
+  add_bytes(&value, sizeof(value));
+  return *this;
+}
+
+Key& Key::add(const box_type_fp& box) {
+  return add(box.min_corner().x()).add(box.min_corner().y())
+      .add(box.max_corner().x()).add(box.max_corner().y());
+}
+
+Key& Key::add(const multi_polygon_type_fp& mp) {
+  add(mp.size());
+  for (const auto& poly : mp) {
+    add(poly.outer().size());
+    add_bytes(poly.outer().data(), poly.outer().size() * sizeof(point_type_fp));
+    add(poly.inners().size());
+    for (const auto& inner : poly.inners()) {
+      add(inner.size());
+      add_bytes(inner.data(), inner.size() * sizeof(point_type_fp));
+    }
+  }
+  return *this;
+}
+
+Key& Key::add(const multi_linestring_type_fp& mls) {
+  add(mls.size());
+  for (const auto& ls : mls) {
+    add(ls.size());
+    add_bytes(ls.data(), ls.size() * sizeof(point_type_fp));
+  }
+  return *this;
+}
+
+Key& Key::add_snapped(const multi_polygon_type_fp& mp, coordinate_type_fp grid) {
+  const auto add_ring = [&](const ring_type_fp& ring) {
+    add(ring.size());
+    for (const auto& point : ring) {
+      add(std::round(point.x() / grid)).add(std::round(point.y() / grid));
+    }
+  };
+  add(mp.size());
+  for (const auto& poly : mp) {
+    add_ring(poly.outer());
+    add(poly.inners().size());
+    for (const auto& inner : poly.inners()) {
+      add_ring(inner);
+    }
+  }
+  return *this;
+}
+
+bool Key::add_file(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    return false;
+  }
+  const std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  if (in.bad()) {
+    return false;
+  }
+  add(contents);
+  return true;
+}
+
+std::string Key::filename() const {
+  return cache_directory + "/" + kind + "-" + (boost::format("%016x") % hash).str() + ".bin";
+}
+
+uint64_t Key::digest() const {
+  return hash;
+}
+
+// The values are written in the machine's own byte order.  The cache isn't
+// meant to be shared between machines.
+static void write(std::ostream& out, uint64_t value) {
+  out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static void write(std::ostream& out, double value) {
+  out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename Points>
+static void write_points(std::ostream& out, const Points& points) {
+  write(out, uint64_t(points.size()));
+  for (const auto& point : points) {
+    write(out, point.x());
+    write(out, point.y());
+  }
+}
+
+static void write(std::ostream& out, bool value) {
+  write(out, uint64_t(value));
+}
+
+static void write(std::ostream& out, const linestring_type_fp& ls) {
+  write_points(out, ls);
+}
+
+static void write(std::ostream& out, const multi_polygon_type_fp& mp) {
+  write(out, uint64_t(mp.size()));
+  for (const auto& poly : mp) {
+    write_points(out, poly.outer());
+    write(out, uint64_t(poly.inners().size()));
+    for (const auto& inner : poly.inners()) {
+      write_points(out, inner);
+    }
+  }
+}
+
+static void write(std::ostream& out, const multi_linestring_type_fp& mls) {
+  write(out, uint64_t(mls.size()));
+  for (const auto& ls : mls) {
+    write_points(out, ls);
+  }
+}
+
+// The containers can hold each other so they are declared first.
+template <typename T>
+static void write(std::ostream& out, const std::vector<T>& values);
+
+template <typename K, typename V>
+static void write(std::ostream& out, const std::map<K, V>& values) {
+  write(out, uint64_t(values.size()));
+  for (const auto& value : values) {
+    write(out, value.first);
+    write(out, value.second);
+  }
+}
+
+template <typename A, typename B>
+static void write(std::ostream& out, const std::pair<A, B>& value) {
+  write(out, value.first);
+  write(out, value.second);
+}
+
+template <typename T>
+static void write(std::ostream& out, const std::vector<T>& values) {
+  write(out, uint64_t(values.size()));
+  for (const auto& value : values) {
+    write(out, value);
+  }
+}
+
+// Each read returns false if the input is truncated or corrupt.
+static bool read(std::istream& in, uint64_t& value) {
+  return bool(in.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+static bool read(std::istream& in, double& value) {
+  return bool(in.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+static bool read(std::istream& in, double& value, uint64_t) {
+  return read(in, value);
+}
+
+// Don't trust a size that is larger than what's left in the file.
+static bool read_size(std::istream& in, uint64_t& size, uint64_t element_size, uint64_t remaining) {
+  return read(in, size) && size <= remaining / element_size;
+}
+
+template <typename Points>
+static bool read_points(std::istream& in, Points& points, uint64_t remaining) {
+  uint64_t size;
+  if (!read_size(in, size, 2 * sizeof(double), remaining)) {
+    return false;
+  }
+  points.resize(size);
+  for (auto& point : points) {
+    double x, y;
+    if (!read(in, x) || !read(in, y)) {
+      return false;
+    }
+    point = {x, y};
+  }
+  return true;
+}
+
+static bool read(std::istream& in, bool& value, uint64_t) {
+  uint64_t stored;
+  if (!read(in, stored) || stored > 1) {
+    return false;
+  }
+  value = stored;
+  return true;
+}
+
+static bool read(std::istream& in, linestring_type_fp& ls, uint64_t remaining) {
+  return read_points(in, ls, remaining);
+}
+
+static bool read(std::istream& in, multi_polygon_type_fp& mp, uint64_t remaining) {
+  uint64_t size;
+  if (!read_size(in, size, 2 * sizeof(uint64_t), remaining)) {
+    return false;
+  }
+  mp.resize(size);
+  for (auto& poly : mp) {
+    uint64_t inners;
+    if (!read_points(in, poly.outer(), remaining) ||
+        !read_size(in, inners, sizeof(uint64_t), remaining)) {
+      return false;
+    }
+    poly.inners().resize(inners);
+    for (auto& inner : poly.inners()) {
+      if (!read_points(in, inner, remaining)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+static bool read(std::istream& in, multi_linestring_type_fp& mls, uint64_t remaining) {
+  uint64_t size;
+  if (!read_size(in, size, sizeof(uint64_t), remaining)) {
+    return false;
+  }
+  mls.resize(size);
+  for (auto& ls : mls) {
+    if (!read_points(in, ls, remaining)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <typename T>
+static bool read(std::istream& in, std::vector<T>& values, uint64_t remaining);
+
+template <typename K, typename V>
+static bool read(std::istream& in, std::map<K, V>& values, uint64_t remaining) {
+  uint64_t size;
+  if (!read_size(in, size, sizeof(K) + sizeof(uint64_t), remaining)) {
+    return false;
+  }
+  for (uint64_t i = 0; i < size; i++) {
+    K key;
+    V value;
+    if (!read(in, key) || !read(in, value, remaining)) {
+      return false;
+    }
+    values.emplace(key, std::move(value));
+  }
+  return true;
+}
+
+template <typename A, typename B>
+static bool read(std::istream& in, std::pair<A, B>& value, uint64_t remaining) {
+  return read(in, value.first, remaining) && read(in, value.second, remaining);
+}
+
+template <typename T>
+static bool read(std::istream& in, std::vector<T>& values, uint64_t remaining) {
+  uint64_t size;
+  if (!read_size(in, size, sizeof(uint64_t), remaining)) {
+    return false;
+  }
+  values.resize(size);
+  for (auto& value : values) {
+    if (!read(in, value, remaining)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <typename T>
+boost::optional<T> load(const Key& key) {
+  if (!enabled()) {
+    return boost::none;
+  }
+  std::ifstream in(key.filename(), std::ios::binary | std::ios::ate);
+  if (!in) {
+    stats::add("disk cache misses", 1);
+    return boost::none;
+  }
+  const uint64_t file_size = in.tellg();
+  in.seekg(0);
+  char magic[sizeof(MAGIC)];
+  uint64_t version;
+  T value;
+  if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 ||
+      !read(in, version) || version != FORMAT_VERSION ||
+      !read(in, value, file_size) || in.peek() != std::char_traits<char>::eof()) {
+    std::cerr << "Warning: ignoring corrupt cache file " << key.filename() << std::endl;
+    stats::add("disk cache misses", 1);
+    return boost::none;
+  }
+  in.close();
+  touch(key.filename());
+  stats::add("disk cache hits", 1);
+  return value;
+}
+
+// Like std::rename but replaces the target if it already exists, which
+// std::rename doesn't do on Windows.
+static bool replace_file(const std::string& from, const std::string& to) {
+#ifdef _WIN32
+  return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+  return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+template <typename T>
+void save(const Key& key, const T& value) {
+  if (!enabled()) {
+    return;
+  }
+  // Write to a temporary file and then rename it so that another run never
+  // sees half a file.
+  const std::string filename = key.filename();
+  const std::string temporary = filename + ".tmp";
+  {
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    out.write(MAGIC, sizeof(MAGIC));
+    write(out, uint64_t(FORMAT_VERSION));
+    write(out, value);
+    out.close();
+    if (out && replace_file(temporary, filename)) {
+      return;
+    }
+  }
+  std::remove(temporary.c_str());
+  static std::once_flag warned;
+  std::call_once(warned, [&]() {
+    std::cerr << "Warning: can't write to the cache in " << cache_directory << std::endl;
+  });
+}
+
+template boost::optional<multi_polygon_type_fp> load(const Key&);
+template void save(const Key&, const multi_polygon_type_fp&);
+template boost::optional<Rendered> load(const Key&);
+template void save(const Key&, const Rendered&);
+template boost::optional<Toolpaths> load(const Key&);
+template void save(const Key&, const Toolpaths&);
+template boost::optional<TraceToolpaths> load(const Key&);
+template void save(const Key&, const TraceToolpaths&);
+
+} // namespace disk_cache
@@ -0,0 +1,77 @@
+#ifndef DISK_CACHE_HPP
+#define DISK_CACHE_HPP
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/optional.hpp>
+
+#include "geometry.hpp"
+
+namespace disk_cache {
+
+// Rendering the gerber files, building the voronoi regions and making the
+// toolpaths are slow but don't depend on the options for exporting the gcode,
+// so the results can be kept on disk and reused by the next run on the same
+// board.  Nothing is cached until a directory is set.  An empty directory
+// disables the cache.  trim() keeps the directory under max_size bytes by
+// removing the files that were used least recently.  0 is no limit.
+void set_directory(const std::string& directory, uint64_t max_size = 0);
+bool enabled();
+void trim();
+
+// The version of the code that makes each kind of value.  Bump it when that
+// code changes what it makes so that values made by the old code aren't
+// used.  Builds without git all have the same git version.
+const uint32_t RENDER_VERSION = 1;
+const uint32_t VORONOI_VERSION = 1;
+const uint32_t TOOLPATH_VERSION = 1;
+
+// Identifies a cached value by a hash of everything that it was made from.
+// The kind of value, its version and the pcb2gcode version are always
+// included.
+class Key {
+ public:
+  Key(const std::string& kind, uint32_t version);
+  Key& add(const std::string& value);
+  Key& add(double value);
+  Key& add(const box_type_fp& box);
+  Key& add(const multi_polygon_type_fp& mp);
+  Key& add(const multi_linestring_type_fp& mls);
+  // Adds the coordinates rounded to the grid, so that shapes that differ only
+  // by rounding errors usually get the same key.
+  Key& add_snapped(const multi_polygon_type_fp& mp, coordinate_type_fp grid);
+  // Adds the contents of the file.  Returns false if it can't be read.
+  bool add_file(const std::string& path);
+  std::string filename() const;
+  // The hash, for keeping several values in one file.
+  uint64_t digest() const;
+
+ private:
+  void add_bytes(const void* bytes, size_t size);
+  const std::string kind;
+  uint64_t hash;
+};
+
+typedef std::pair<multi_polygon_type_fp, std::map<coordinate_type_fp, multi_linestring_type_fp>> Rendered;
+// The toolpath for each tool diameter.
+typedef std::vector<std::pair<coordinate_type_fp, multi_linestring_type_fp>> Toolpaths;
+// The passes around one trace, each with whether it may be reversed.
+typedef std::vector<std::pair<linestring_type_fp, bool>> TraceToolpath;
+// The passes around each trace of a layer, by the digest of the trace's key.
+typedef std::map<uint64_t, TraceToolpath> TraceToolpaths;
+
+// Returns the cached value, if there is one for the key and it can be read.
+template <typename T>
+boost::optional<T> load(const Key& key);
+// Stores the value for the key, replacing any old one.  Failures are only
+// warned about because the cache is just an optimization.
+template <typename T>
+void save(const Key& key, const T& value);
+
+} // namespace disk_cache
+
+#endif // DISK_CACHE_HPP
@@ -0,0 +1,163 @@
+#define BOOST_TEST_MODULE disk cache tests
+#include <boost/test/unit_test.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <utime.h>
+
+#include <boost/lexical_cast.hpp>
+
+#include "disk_cache.hpp"
+
+using disk_cache::Key;
+using disk_cache::load;
+using disk_cache::save;
+
+BOOST_AUTO_TEST_SUITE(disk_cache_tests)
+
+const std::string directory = "disk_cache_tests_output";
+
+BOOST_AUTO_TEST_CASE(disabled) {
+  disk_cache::set_directory("");
+  BOOST_CHECK(!disk_cache::enabled());
+  Key key("test", 1);
+  key.add(1.0);
+  save(key, multi_polygon_type_fp{});
+  BOOST_CHECK(!load<multi_polygon_type_fp>(key));
+}
+
+BOOST_AUTO_TEST_CASE(keys) {
+  disk_cache::set_directory(directory);
+  BOOST_CHECK_EQUAL(Key("test", 1).add(1.0).filename(), Key("test", 1).add(1.0).filename());
+  BOOST_CHECK_NE(Key("test", 1).add(1.0).filename(), Key("test", 1).add(2.0).filename());
+  BOOST_CHECK_NE(Key("test", 1).add(1.0).filename(), Key("other", 1).add(1.0).filename());
+  BOOST_CHECK_NE(Key("test", 1).add(1.0).filename(), Key("test", 2).add(1.0).filename());
+  BOOST_CHECK_NE(Key("test", 1).add("ab").add("c").filename(), Key("test", 1).add("a").add("bc").filename());
+  multi_polygon_type_fp mp;
+  bg::read_wkt("MULTIPOLYGON(((0 0,0 1,1 1,1 0,0 0)))", mp);
+  multi_polygon_type_fp moved;
+  bg::read_wkt("MULTIPOLYGON(((0 0,0 1,1 1,1 0.5,0 0)))", moved);
+  BOOST_CHECK_EQUAL(Key("test", 1).add(mp).filename(), Key("test", 1).add(mp).filename());
+  BOOST_CHECK_NE(Key("test", 1).add(mp).filename(), Key("test", 1).add(moved).filename());
+  BOOST_CHECK(!Key("test", 1).add_file(directory + "/no_such_file"));
+  multi_polygon_type_fp rounded;
+  bg::read_wkt("MULTIPOLYGON(((0 0,0 1.0000000000000002,1 1,1 0,0 0)))", rounded);
+  BOOST_CHECK_NE(Key("test", 1).add(mp).filename(), Key("test", 1).add(rounded).filename());
+  BOOST_CHECK_EQUAL(Key("test", 1).add_snapped(mp, 1e-9).filename(), Key("test", 1).add_snapped(rounded, 1e-9).filename());
+  BOOST_CHECK_NE(Key("test", 1).add_snapped(mp, 1e-9).filename(), Key("test", 1).add_snapped(moved, 1e-9).filename());
+}
+
+BOOST_AUTO_TEST_CASE(round_trip) {
+  disk_cache::set_directory(directory);
+  disk_cache::Rendered rendered;
+  bg::read_wkt("MULTIPOLYGON(((0 0,0 10,10 10,10 0,0 0),(2 2,8 2,8 8,2 8,2 2)),((20 0,20 1,21 1,20 0)))",
+               rendered.first);
+  bg::read_wkt("MULTILINESTRING((0 0,1 1,2 0),(5 5,6 6))", rendered.second[0.01]);
+  rendered.second[0.02];
+  Key key("test", 1);
+  key.add("round_trip");
+  save(key, rendered);
+  const auto loaded = load<disk_cache::Rendered>(key);
+  BOOST_REQUIRE(loaded);
+  BOOST_CHECK(bg::equals(loaded->first, rendered.first));
+  BOOST_REQUIRE_EQUAL(loaded->second.size(), 2);
+  BOOST_CHECK_EQUAL(boost::lexical_cast<std::string>(bg::wkt(loaded->second.at(0.01))),
+                    boost::lexical_cast<std::string>(bg::wkt(rendered.second.at(0.01))));
+  BOOST_CHECK(loaded->second.at(0.02).empty());
+
+  Key missing("test", 1);
+  missing.add("missing");
+  BOOST_CHECK(!load<disk_cache::Rendered>(missing));
+}
+
+BOOST_AUTO_TEST_CASE(toolpaths) {
+  disk_cache::set_directory(directory);
+  disk_cache::Toolpaths toolpaths(2);
+  toolpaths[0].first = 0.01;
+  bg::read_wkt("MULTILINESTRING((0 0,1 1,2 0),(5 5,6 6))", toolpaths[0].second);
+  toolpaths[1].first = 0.1;
+  Key key("test", 1);
+  key.add("toolpaths");
+  save(key, toolpaths);
+  const auto loaded = load<disk_cache::Toolpaths>(key);
+  BOOST_REQUIRE(loaded);
+  BOOST_REQUIRE_EQUAL(loaded->size(), 2);
+  BOOST_CHECK_EQUAL(loaded->at(0).first, 0.01);
+  BOOST_CHECK_EQUAL(boost::lexical_cast<std::string>(bg::wkt(loaded->at(0).second)),
+                    boost::lexical_cast<std::string>(bg::wkt(toolpaths[0].second)));
+  BOOST_CHECK_EQUAL(loaded->at(1).first, 0.1);
+  BOOST_CHECK(loaded->at(1).second.empty());
+}
+
+BOOST_AUTO_TEST_CASE(trace_toolpaths) {
+  disk_cache::set_directory(directory);
+  disk_cache::TraceToolpaths trace_toolpaths;
+  trace_toolpaths[Key("test", 1).add(1.0).digest()].emplace_back(linestring_type_fp{{0, 0}, {1, 1}}, true);
+  trace_toolpaths[Key("test", 1).add(2.0).digest()];
+  Key key("test", 1);
+  key.add("trace_toolpaths");
+  save(key, trace_toolpaths);
+  const auto loaded = load<disk_cache::TraceToolpaths>(key);
+  BOOST_REQUIRE(loaded);
+  BOOST_REQUIRE_EQUAL(loaded->size(), 2);
+  const auto& first = loaded->at(Key("test", 1).add(1.0).digest());
+  BOOST_REQUIRE_EQUAL(first.size(), 1);
+  BOOST_CHECK(bg::equals(first[0].first, linestring_type_fp{{0, 0}, {1, 1}}));
+  BOOST_CHECK(first[0].second);
+  BOOST_CHECK(loaded->at(Key("test", 1).add(2.0).digest()).empty());
+}
+
+BOOST_AUTO_TEST_CASE(corrupt) {
+  disk_cache::set_directory(directory);
+  multi_polygon_type_fp mp;
+  bg::read_wkt("MULTIPOLYGON(((0 0,0 1,1 1,1 0,0 0)))", mp);
+  Key key("test", 1);
+  key.add("corrupt");
+  save(key, mp);
+  BOOST_CHECK(load<multi_polygon_type_fp>(key));
+  // Cut the file short.
+  std::ifstream in(key.filename(), std::ios::binary);
+  std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  in.close();
+  std::ofstream(key.filename(), std::ios::binary) << contents.substr(0, contents.size() - 4);
+  BOOST_CHECK(!load<multi_polygon_type_fp>(key));
+  // A huge size shouldn't allocate everything.
+  contents.replace(16, 8, std::string(8, '\xff'));
+  std::ofstream(key.filename(), std::ios::binary) << contents;
+  BOOST_CHECK(!load<multi_polygon_type_fp>(key));
+  std::remove(key.filename().c_str());
+}
+
+BOOST_AUTO_TEST_CASE(trim) {
+  multi_polygon_type_fp mp;
+  bg::read_wkt("MULTIPOLYGON(((0 0,0 1,1 1,1 0,0 0)))", mp);
+  std::vector<Key> keys;
+  for (int i = 0; i < 3; i++) {
+    keys.push_back(Key("test", 1).add("trim").add(i));
+  }
+  // Alone in its directory so that the files of the other tests aren't
+  // counted.  Find the size of one file.
+  const std::string trim_directory = directory + "_trim";
+  disk_cache::set_directory(trim_directory);
+  save(keys[0], mp);
+  std::ifstream in(keys[0].filename(), std::ios::binary | std::ios::ate);
+  const uint64_t file_size = in.tellg();
+  in.close();
+  // Room for two files, with the first one written longest ago.
+  disk_cache::set_directory(trim_directory, 2 * file_size);
+  for (int i = 0; i < 3; i++) {
+    save(keys[i], mp);
+    utimbuf times{1000 + i, 1000 + i};
+    utime(keys[i].filename().c_str(), &times);
+  }
+  // Reading the first one makes the second one the oldest.
+  BOOST_CHECK(load<multi_polygon_type_fp>(keys[0]));
+  disk_cache::trim();
+  BOOST_CHECK(load<multi_polygon_type_fp>(keys[0]));
+  BOOST_CHECK(!load<multi_polygon_type_fp>(keys[1]));
+  BOOST_CHECK(load<multi_polygon_type_fp>(keys[2]));
+  std::remove(keys[0].filename().c_str());
+  std::remove(keys[2].filename().c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,303 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "bg_operators.hpp"
+#include "distance_field.hpp"
+#include "parallel.hpp"
+
+namespace distance_field {
+
+using std::vector;
+
+// Farther than any real distance but small enough to add squares to.
+static const double far = 1e20;
+
+// For each cell, 1 if its center is inside the shapes, otherwise 0.  Each row
+// is filled between pairs of crossings of the shapes' edges, so holes work
+// without any special handling.
+static vector<uint8_t> rasterize(const multi_polygon_type_fp& shapes, const box_type_fp& bounds,
+                                 double resolution, size_t width, size_t height,
+                                 unsigned int threads) {
+  const auto& min_corner = bounds.min_corner();
+  // The first row whose center is at or above y.
+  const auto first_row = [&](double y) {
+    return std::min(double(height), std::max(0., std::ceil((y - min_corner.y()) / resolution - 0.5)));
+  };
+  vector<vector<double>> crossings(height);
+  const auto add_ring = [&](const ring_type_fp& ring) {
+    for (size_t i = 0; i + 1 < ring.size(); i++) {
+      const auto& p = ring[i];
+      const auto& q = ring[i + 1];
+      if (p.y() == q.y()) {
+        continue;
+      }
+      const size_t begin = first_row(std::min(p.y(), q.y()));
+      const size_t end = first_row(std::max(p.y(), q.y()));
+      for (size_t row = begin; row < end; row++) {
+        const double y = min_corner.y() + (row + 0.5) * resolution;
+        crossings[row].push_back(p.x() + (y - p.y()) * (q.x() - p.x()) / (q.y() - p.y()));
+      }
+    }
+  };
+  for (const auto& poly : shapes) {
+    add_ring(poly.outer());
+    for (const auto& inner : poly.inners()) {
+      add_ring(inner);
+    }
+  }
+
+  vector<uint8_t> inside(width * height, 0);
+  parallel::for_ranges(height, threads, [&](size_t begin, size_t end) {
+    for (size_t row = begin; row < end; row++) {
+      auto& row_crossings = crossings[row];
+      std::sort(row_crossings.begin(), row_crossings.end());
+      const auto first_column = [&](double x) {
+        return size_t(std::min(double(width), std::max(0., std::ceil((x - min_corner.x()) / resolution - 0.5))));
+      };
+      for (size_t i = 0; i + 1 < row_crossings.size(); i += 2) {
+        std::fill(inside.begin() + row * width + first_column(row_crossings[i]),
+                  inside.begin() + row * width + first_column(row_crossings[i + 1]),
+                  1);
+      }
+    }
+  });
+  return inside;
+}
+
+// The squared distance transform of a line of n samples: d[q] is the minimum
+// of (q-p)^2 + f[p] over all p.  This is the lower envelope of parabolas from
+// Felzenszwalb and Huttenlocher, "Distance Transforms of Sampled Functions".
+// v and z are scratch space of at least n and n+1.
+static void distance_transform(const double* f, size_t n, double* d, size_t* v, double* z) {
+  // The intersection of the parabolas from q and p.
+  const auto intersection = [&](size_t q, size_t p) {
+    return ((f[q] + double(q) * q) - (f[p] + double(p) * p)) / (2 * (double(q) - p));
+  };
+  size_t k = 0;
+  v[0] = 0;
+  z[0] = -INFINITY;
+  z[1] = INFINITY;
+  for (size_t q = 1; q < n; q++) {
+    double s = intersection(q, v[k]);
+    while (s <= z[k]) {
+      k--;
+      s = intersection(q, v[k]);
+    }
+    k++;
+    v[k] = q;
+    z[k] = s;
+    z[k + 1] = INFINITY;
+  }
+  k = 0;
+  for (size_t q = 0; q < n; q++) {
+    while (z[k + 1] < q) {
+      k++;
+    }
+    const double p = v[k];
+    d[q] = (q - p) * (q - p) + f[v[k]];
+  }
+}
+
+// For each cell, the squared distance, in cells, to the nearest cell where
+// inside is equal to target.  Rows are done first and then columns, each in
+// parallel.
+static vector<float> squared_distances(const vector<uint8_t>& inside, uint8_t target,
+                                       size_t width, size_t height, unsigned int threads) {
+  vector<float> rows(width * height);
+  parallel::for_ranges(height, threads, [&](size_t begin, size_t end) {
+    vector<double> f(width), d(width), z(width + 1);
+    vector<size_t> v(width);
+    for (size_t y = begin; y < end; y++) {
+      for (size_t x = 0; x < width; x++) {
+        f[x] = inside[y * width + x] == target ? 0 : far;
+      }
+      distance_transform(f.data(), width, d.data(), v.data(), z.data());
+      std::copy(d.cbegin(), d.cend(), rows.begin() + y * width);
+    }
+  });
+  vector<float> ret(width * height);
+  parallel::for_ranges(width, threads, [&](size_t begin, size_t end) {
+    vector<double> f(height), d(height), z(height + 1);
+    vector<size_t> v(height);
+    for (size_t x = begin; x < end; x++) {
+      for (size_t y = 0; y < height; y++) {
+        f[y] = rows[y * width + x];
+      }
+      distance_transform(f.data(), height, d.data(), v.data(), z.data());
+      for (size_t y = 0; y < height; y++) {
+        ret[y * width + x] = d[y];
+      }
+    }
+  });
+  return ret;
+}
+
+// The number of cells along a side of length size.
+static size_t cells_along(double size, double resolution) {
+  return std::max(1., std::ceil(size / resolution));
+}
+
+// The resolution, made coarser if needed so that the grid has no more than
+// max_cells cells.
+static double grid_resolution(const box_type_fp& bounds, double resolution, size_t max_cells) {
+  const double width = bounds.max_corner().x() - bounds.min_corner().x();
+  const double height = bounds.max_corner().y() - bounds.min_corner().y();
+  const auto cells = [&](double resolution) {
+    return double(cells_along(width, resolution)) * cells_along(height, resolution);
+  };
+  if (cells(resolution) <= max_cells) {
+    return resolution;
+  }
+  resolution = std::max({resolution, std::sqrt(width * height / max_cells),
+                         width / max_cells, height / max_cells});
+  // Rounding up to whole cells might still make too many.
+  while (cells(resolution) > max_cells) {
+    resolution *= 1.01;
+  }
+  return resolution;
+}
+
+DistanceField::DistanceField(const multi_polygon_type_fp& shapes, const box_type_fp& bounds,
+                             double resolution, unsigned int threads, size_t max_cells) :
+    bounds_(bounds),
+    resolution_(grid_resolution(bounds, resolution, max_cells)),
+    threads(threads > 0 ? threads : parallel::hardware_threads()),
+    width_(cells_along(bounds.max_corner().x() - bounds.min_corner().x(), resolution_)),
+    height_(cells_along(bounds.max_corner().y() - bounds.min_corner().y(), resolution_)),
+    values(width_ * height_) {
+  const auto inside = rasterize(shapes, bounds, resolution_, width_, height_, this->threads);
+  const auto to_inside = squared_distances(inside, 1, width_, height_, this->threads);
+  const auto to_outside = squared_distances(inside, 0, width_, height_, this->threads);
+  // The edge is half a cell from the center of the nearest cell on the other
+  // side.
+  parallel::for_ranges(values.size(), this->threads, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      if (inside[i]) {
+        values[i] = -(std::sqrt(to_outside[i]) - 0.5) * resolution_;
+      } else {
+        values[i] = (std::sqrt(to_inside[i]) - 0.5) * resolution_;
+      }
+    }
+  });
+}
+
+// Marching squares over the cell centers, with a border of cells all around
+// the grid that count as outside so that every contour is closed.  Each grid
+// square contributes segments directed so that the inside is on the right,
+// which makes outer rings clockwise and holes counter-clockwise.  The rings
+// are then filled with the even-odd rule.
+multi_polygon_type_fp DistanceField::offset(double distance) const {
+  // Coordinates are shifted by one for the border.
+  const size_t padded_width = width_ + 2;
+  const size_t padded_height = height_ + 2;
+  const auto value = [&](size_t x, size_t y) -> double {
+    if (x == 0 || y == 0 || x > width_ || y > height_) {
+      return INFINITY;
+    }
+    return at(x - 1, y - 1);
+  };
+  const auto center = [&](size_t x, size_t y) {
+    return point_type_fp(bounds_.min_corner().x() + (double(x) - 0.5) * resolution_,
+                         bounds_.min_corner().y() + (double(y) - 0.5) * resolution_);
+  };
+  // Each crossing is on the edge between two neighboring cell centers.  The
+  // key is from the lower-left one and the direction of the edge.
+  const auto edge_key = [&](size_t x, size_t y, bool vertical) {
+    return (y * padded_width + x) * 2 + (vertical ? 1 : 0);
+  };
+  std::unordered_map<size_t, size_t> next;
+  vector<size_t> starts;  // In the order found, so that the output is repeatable.
+  std::unordered_map<size_t, point_type_fp> crossing_points;
+  const auto add_crossing = [&](size_t x, size_t y, bool vertical) {
+    const auto key = edge_key(x, y, vertical);
+    if (crossing_points.count(key) == 0) {
+      const size_t x1 = vertical ? x : x + 1;
+      const size_t y1 = vertical ? y + 1 : y;
+      const double v0 = value(x, y);
+      const double v1 = value(x1, y1);
+      double t = 0.5;
+      if (std::isfinite(v0) && std::isfinite(v1)) {
+        // Stay off the cell centers so that no two rings touch.
+        t = std::min(0.999, std::max(0.001, (distance - v0) / (v1 - v0)));
+      }
+      const auto p0 = center(x, y);
+      const auto p1 = center(x1, y1);
+      crossing_points.emplace(key, point_type_fp(p0.x() + (p1.x() - p0.x()) * t,
+                                                 p0.y() + (p1.y() - p0.y()) * t));
+    }
+    return key;
+  };
+  for (size_t y = 0; y + 1 < padded_height; y++) {
+    for (size_t x = 0; x + 1 < padded_width; x++) {
+      // Corners counter-clockwise from the lower-left.
+      const double corners[4] = {value(x, y), value(x + 1, y), value(x + 1, y + 1), value(x, y + 1)};
+      bool inside[4];
+      for (size_t i = 0; i < 4; i++) {
+        inside[i] = corners[i] <= distance;
+      }
+      if (inside[0] == inside[1] && inside[1] == inside[2] && inside[2] == inside[3]) {
+        continue;
+      }
+      // Crossings counter-clockwise around the square, and whether they
+      // enter the inside.
+      size_t keys[4];
+      bool enters[4];
+      size_t count = 0;
+      for (size_t i = 0; i < 4; i++) {
+        const size_t j = (i + 1) % 4;
+        if (inside[i] == inside[j]) {
+          continue;
+        }
+        switch (i) {
+          case 0: keys[count] = add_crossing(x, y, false); break;
+          case 1: keys[count] = add_crossing(x + 1, y, true); break;
+          case 2: keys[count] = add_crossing(x, y + 1, false); break;
+          case 3: keys[count] = add_crossing(x, y, true); break;
+        }
+        enters[count] = inside[j];
+        count++;
+      }
+      // Each entering crossing is joined to an exiting one.  Usually there is
+      // only one choice but, for a saddle, the middle of the square decides
+      // if the inside corners are joined.
+      const double middle = (corners[0] + corners[1] + corners[2] + corners[3]) / 4;
+      const size_t step = count == 4 && middle <= distance ? count - 1 : 1;
+      for (size_t i = 0; i < count; i++) {
+        if (enters[i]) {
+          next[keys[i]] = keys[(i + step) % count];
+          starts.push_back(keys[i]);
+        }
+      }
+    }
+  }
+
+  vector<multi_polygon_type_fp> rings;
+  std::unordered_set<size_t> visited;
+  for (const auto& start : starts) {
+    if (visited.count(start) > 0) {
+      continue;
+    }
+    ring_type_fp ring;
+    auto key = start;
+    do {
+      visited.insert(key);
+      ring.push_back(crossing_points.at(key));
+      key = next.at(key);
+    } while (key != start);
+    ring.push_back(ring.front());
+    polygon_type_fp poly;
+    poly.outer() = ring;
+    bg::correct(poly);
+    rings.push_back(multi_polygon_type_fp{poly});
+  }
+  const auto filled = symdiff(rings);
+  multi_polygon_type_fp ret;
+  bg::simplify(filled, ret, resolution_ / 4);
+  return ret;
+}
+
+} // namespace distance_field
@@ -0,0 +1,55 @@
+#ifndef DISTANCE_FIELD_HPP
+#define DISTANCE_FIELD_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include "geometry.hpp"
+
+namespace distance_field {
+
+// The shapes are rasterized onto a grid of square cells and, for each cell,
+// the distance to the edge of the shapes is found, negative inside the shapes
+// and positive outside.  Offsets of the shapes by any distance can then be
+// traced from the grid in time proportional to the number of cells, no matter
+// how complex the shapes are.  The precision is about the cell size so this is
+// for making quick drafts.
+class DistanceField {
+ public:
+  // Each cell needs about 20 bytes while the field is made, so this is a few
+  // hundred megabytes.
+  static const size_t default_max_cells = 16 * 1024 * 1024;
+
+  // The grid covers bounds with cells of size resolution.  Distances are
+  // correct up to the edge of the grid, so bounds should include some margin
+  // around the shapes.  If that would need more than max_cells cells then the
+  // cells are made larger, see resolution().  The work is split among
+  // threads, 0 for as many as the hardware supports.
+  DistanceField(const multi_polygon_type_fp& shapes, const box_type_fp& bounds,
+                double resolution, unsigned int threads = 0,
+                size_t max_cells = default_max_cells);
+  // The shapes grown by distance, or shrunk if it is negative.  The outline
+  // is traced between the cell centers and then simplified by a quarter of a
+  // cell.
+  multi_polygon_type_fp offset(double distance) const;
+  // The distance of the center of the cell at column x and row y, counting
+  // from the minimum corner of the bounds.
+  double at(size_t x, size_t y) const { return values[y * width_ + x]; }
+  size_t width() const { return width_; }
+  size_t height() const { return height_; }
+  const box_type_fp& bounds() const { return bounds_; }
+  // The size of the cells, which may be larger than requested.
+  double resolution() const { return resolution_; }
+
+ private:
+  box_type_fp bounds_;
+  double resolution_;
+  unsigned int threads;
+  size_t width_;
+  size_t height_;
+  std::vector<float> values;
+};
+
+} // namespace distance_field
+
+#endif // DISTANCE_FIELD_HPP
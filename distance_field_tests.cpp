@@ -0,0 +1,85 @@
+#define BOOST_TEST_MODULE distance field tests
+#include <boost/test/unit_test.hpp>
+
+#include <boost/math/constants/constants.hpp>
+
+#include "geometry.hpp"
+#include "bg_operators.hpp"
+#include "distance_field.hpp"
+#include "test_shapes.hpp"
+
+using distance_field::DistanceField;
+
+BOOST_AUTO_TEST_SUITE(distance_field_tests)
+
+const double pi = boost::math::constants::pi<double>();
+
+BOOST_AUTO_TEST_CASE(empty) {
+  DistanceField field(multi_polygon_type_fp(), box_type_fp{{0, 0}, {1, 1}}, 0.1);
+  BOOST_CHECK_EQUAL(field.width(), 10UL);
+  BOOST_CHECK_EQUAL(field.height(), 10UL);
+  BOOST_CHECK_GT(field.at(5, 5), 1);
+  BOOST_CHECK_EQUAL(field.offset(0.1).size(), 0UL);
+}
+
+BOOST_AUTO_TEST_CASE(distances) {
+  DistanceField field(square(0, 0, 1), box_type_fp{{-1, -1}, {2, 2}}, 0.01);
+  BOOST_CHECK_EQUAL(field.width(), 300UL);
+  // The center of the square.
+  BOOST_CHECK_CLOSE(field.at(150, 150), -0.5, 2);
+  // Half way from the square to the edge of the grid.
+  BOOST_CHECK_CLOSE(field.at(50, 150), 0.5, 2);
+  // Diagonally away from a corner.
+  BOOST_CHECK_CLOSE(field.at(50, 50), 0.5 * std::sqrt(2), 2);
+}
+
+BOOST_AUTO_TEST_CASE(offsets) {
+  DistanceField field(square(0, 0, 1), box_type_fp{{-1, -1}, {2, 2}}, 0.01);
+  BOOST_CHECK_CLOSE(bg::area(field.offset(0)), 1, 1);
+  BOOST_CHECK_CLOSE(bg::area(field.offset(0.2)), 1 + 4 * 0.2 + pi * 0.2 * 0.2, 1);
+  BOOST_CHECK_CLOSE(bg::area(field.offset(-0.2)), 0.6 * 0.6, 1);
+  const auto grown = field.offset(0.2);
+  BOOST_CHECK_EQUAL(grown.size(), 1UL);
+  BOOST_CHECK(bg::is_valid(grown));
+  BOOST_CHECK(bg::covered_by(square(0, 0, 1), grown));
+}
+
+BOOST_AUTO_TEST_CASE(holes) {
+  const multi_polygon_type_fp frame = square(0, 0, 3) - square(1, 1, 1);
+  DistanceField field(frame, box_type_fp{{-1, -1}, {4, 4}}, 0.01);
+  const auto same = field.offset(0);
+  BOOST_REQUIRE_EQUAL(same.size(), 1UL);
+  BOOST_CHECK_EQUAL(same[0].inners().size(), 1UL);
+  BOOST_CHECK_CLOSE(bg::area(same), 8, 1);
+  // The hole closes up.
+  const auto grown = field.offset(0.6);
+  BOOST_REQUIRE_EQUAL(grown.size(), 1UL);
+  BOOST_CHECK_EQUAL(grown[0].inners().size(), 0UL);
+}
+
+BOOST_AUTO_TEST_CASE(threads) {
+  multi_polygon_type_fp shapes{square(0, 0, 1).front(), square(1.5, 0.2, 0.3).front()};
+  DistanceField one(shapes, box_type_fp{{-1, -1}, {3, 2}}, 0.02, 1);
+  DistanceField many(shapes, box_type_fp{{-1, -1}, {3, 2}}, 0.02, 7);
+  for (size_t y = 0; y < one.height(); y++) {
+    for (size_t x = 0; x < one.width(); x++) {
+      BOOST_REQUIRE_EQUAL(one.at(x, y), many.at(x, y));
+    }
+  }
+  // The two squares merge.
+  BOOST_CHECK_EQUAL(one.offset(0.1).size(), 2UL);
+  BOOST_CHECK_EQUAL(one.offset(0.3).size(), 1UL);
+}
+
+BOOST_AUTO_TEST_CASE(max_cells) {
+  DistanceField field(square(0, 0, 1), box_type_fp{{-1, -1}, {2, 2}}, 0.001, 0, 10000);
+  BOOST_CHECK_LE(field.width() * field.height(), 10000UL);
+  BOOST_CHECK_GE(field.resolution(), 0.03);
+  BOOST_CHECK_LT(field.resolution(), 0.04);
+  BOOST_CHECK_CLOSE(bg::area(field.offset(0)), 1, 10);
+
+  DistanceField fine(square(0, 0, 1), box_type_fp{{-1, -1}, {2, 2}}, 0.03, 0, 20000);
+  BOOST_CHECK_EQUAL(fine.resolution(), 0.03);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -59,6 +59,7 @@ using std::map;
 #include "units.hpp"
 #include "available_drills.hpp"
 #include "bg_operators.hpp"
+#include "debug_output.hpp"
 
 using std::pair;
 using std::make_pair;
@@ -685,33 +686,42 @@ void ExcellonProcessor::save_svg(
     const map<int, drillbit>& bits,
     const vector<pair<int, multi_linestring_type_fp>>& holes,
     const string& of_dir, const string& of_name) {
-    if (holes.size() == 0) {
+    if (holes.size() == 0 || !debug_output::images()) {
       return;
     }
-    const coordinate_type_fp width = (board_dimensions.max_corner().x() - board_dimensions.min_corner().x()) * SVG_PIX_PER_IN;
-    const coordinate_type_fp height = (board_dimensions.max_corner().y() - board_dimensions.min_corner().y()) * SVG_PIX_PER_IN;
-    const coordinate_type_fp viewBox_width = (board_dimensions.max_corner().x() - board_dimensions.min_corner().x()) * SVG_DOTS_PER_IN;
-    const coordinate_type_fp viewBox_height = (board_dimensions.max_corner().y() - board_dimensions.min_corner().y()) * SVG_DOTS_PER_IN;
-
-    //Some SVG readers does not behave well when viewBox is not specified
-    const string svg_dimensions =
-        str(boost::format("width=\"%1%\" height=\"%2%\" viewBox=\"0 0 %3% %4%\"") % width % height % viewBox_width % viewBox_height);
-
-    ofstream svg_out (build_filename(of_dir, of_name));
-    bg::svg_mapper<point_type_fp> mapper (svg_out, viewBox_width, viewBox_height, svg_dimensions);
-
-    mapper.add(board_dimensions);
-
+    // Each drill hole, with its radius, to draw in the background.
+    vector<pair<point_type_fp, double>> drill_holes;
     for (const auto& hole : holes) {
         const auto& bit = bits.at(hole.first);
         const double radius = bit.unit == "mm" ? (bit.diameter / 25.4) / 2 : bit.diameter / 2;
 
         for (const linestring_type_fp& line : hole.second) {
             for (auto& hole : line_to_holes(line, radius*2)) {
-                mapper.map(hole, "", radius * SVG_DOTS_PER_IN);
+                drill_holes.push_back(std::make_pair(hole, radius));
             }
         }
     }
+    const auto board_dimensions = this->board_dimensions;
+    const auto filename = build_filename(of_dir, of_name);
+    debug_output::write([=]() {
+        const coordinate_type_fp width = (board_dimensions.max_corner().x() - board_dimensions.min_corner().x()) * SVG_PIX_PER_IN;
+        const coordinate_type_fp height = (board_dimensions.max_corner().y() - board_dimensions.min_corner().y()) * SVG_PIX_PER_IN;
+        const coordinate_type_fp viewBox_width = (board_dimensions.max_corner().x() - board_dimensions.min_corner().x()) * SVG_DOTS_PER_IN;
+        const coordinate_type_fp viewBox_height = (board_dimensions.max_corner().y() - board_dimensions.min_corner().y()) * SVG_DOTS_PER_IN;
+
+        //Some SVG readers does not behave well when viewBox is not specified
+        const string svg_dimensions =
+            str(boost::format("width=\"%1%\" height=\"%2%\" viewBox=\"0 0 %3% %4%\"") % width % height % viewBox_width % viewBox_height);
+
+        ofstream svg_out (filename);
+        bg::svg_mapper<point_type_fp> mapper (svg_out, viewBox_width, viewBox_height, svg_dimensions);
+
+        mapper.add(board_dimensions);
+
+        for (const auto& hole_and_radius : drill_holes) {
+            mapper.map(hole_and_radius.first, "", hole_and_radius.second * SVG_DOTS_PER_IN);
+        }
+    });
 }
 
 std::unique_ptr<gerbv_project_t, ExcellonProcessor::GerbvDeleter> ExcellonProcessor::parse_project(const string& filename) {
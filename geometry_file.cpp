@@ -0,0 +1,266 @@
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#ifdef _WIN32
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "geometry_file.hpp"
+
+namespace geometry_file {
+
+using std::runtime_error;
+using std::string;
+using std::vector;
+
+// Bump this when the layout changes.
+static const uint32_t FORMAT_VERSION = 1;
+static const char MAGIC[8] = {'p', '2', 'g', 'g', 'e', 'o', 'm', '\0'};
+// Reads back differently on a machine with the other byte order.
+static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t kind;
+  uint32_t byte_order;
+  uint32_t reserved;
+  uint64_t polygon_count;
+  uint64_t ring_count;
+  uint64_t point_count;
+};
+static_assert(sizeof(Header) % 8 == 0, "The tables after the header must stay aligned.");
+
+template <typename T>
+static void write_array(std::ofstream& out, const vector<T>& values) {
+  out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+}
+
+static void write(const string& filename, Kind kind, const vector<uint64_t>& polygon_offsets,
+                  const vector<uint64_t>& ring_offsets, const vector<double>& coordinates) {
+  Header header;
+  std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.version = FORMAT_VERSION;
+  header.kind = static_cast<uint32_t>(kind);
+  header.byte_order = BYTE_ORDER_MARK;
+  header.reserved = 0;
+  header.polygon_count = polygon_offsets.empty() ? 0 : polygon_offsets.size() - 1;
+  header.ring_count = ring_offsets.size() - 1;
+  header.point_count = coordinates.size() / 2;
+  std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  write_array(out, polygon_offsets);
+  write_array(out, ring_offsets);
+  write_array(out, coordinates);
+  out.close();
+  if (!out) {
+    throw runtime_error("Can't write geometry to " + filename);
+  }
+}
+
+template <typename Points>
+static void add_points(const Points& points, vector<uint64_t>& ring_offsets, vector<double>& coordinates) {
+  for (const auto& point : points) {
+    coordinates.push_back(point.x());
+    coordinates.push_back(point.y());
+  }
+  ring_offsets.push_back(coordinates.size() / 2);
+}
+
+void write(const string& filename, const multi_polygon_type_fp& mp) {
+  vector<uint64_t> polygon_offsets{0};
+  vector<uint64_t> ring_offsets{0};
+  vector<double> coordinates;
+  coordinates.reserve(bg::num_points(mp) * 2);
+  for (const auto& poly : mp) {
+    add_points(poly.outer(), ring_offsets, coordinates);
+    for (const auto& inner : poly.inners()) {
+      add_points(inner, ring_offsets, coordinates);
+    }
+    polygon_offsets.push_back(ring_offsets.size() - 1);
+  }
+  write(filename, Kind::MULTI_POLYGON, polygon_offsets, ring_offsets, coordinates);
+}
+
+void write(const string& filename, const multi_linestring_type_fp& mls) {
+  vector<uint64_t> ring_offsets{0};
+  vector<double> coordinates;
+  coordinates.reserve(bg::num_points(mls) * 2);
+  for (const auto& ls : mls) {
+    add_points(ls, ring_offsets, coordinates);
+  }
+  write(filename, Kind::MULTI_LINESTRING, {}, ring_offsets, coordinates);
+}
+
+bool is_geometry_file(const string& filename) {
+  std::ifstream in(filename, std::ios::binary);
+  char magic[sizeof(MAGIC)];
+  return in.read(magic, sizeof(magic)) && std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+// The contents of a file, mapped into memory where that's possible and read
+// into memory otherwise.
+class Reader::Mapping {
+ public:
+#ifdef _WIN32
+  explicit Mapping(const string& filename) {
+    std::ifstream in(filename, std::ios::binary);
+    if (!in) {
+      throw runtime_error("Can't open " + filename);
+    }
+    const string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    // Stored as uint64_t so that the doubles are aligned.
+    buffer.resize((contents.size() + 7) / 8);
+    std::memcpy(buffer.data(), contents.data(), contents.size());
+    data_ = buffer.data();
+    size_ = contents.size();
+  }
+#else
+  explicit Mapping(const string& filename) {
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw runtime_error("Can't open " + filename);
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0) {
+      close(fd);
+      throw runtime_error("Can't read " + filename);
+    }
+    size_ = file_stat.st_size;
+    if (size_ > 0) {
+      data_ = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (data_ == MAP_FAILED) {
+      data_ = nullptr;
+      throw runtime_error("Can't map " + filename);
+    }
+  }
+  ~Mapping() {
+    if (data_ != nullptr) {
+      munmap(data_, size_);
+    }
+  }
+#endif
+  const char* data() const { return static_cast<const char*>(data_); }
+  size_t size() const { return size_; }
+
+ private:
+  void* data_ = nullptr;
+  size_t size_ = 0;
+#ifdef _WIN32
+  vector<uint64_t> buffer;
+#endif
+};
+
+// The offsets must start at 0, never decrease and end at the count of what
+// they point into.
+static bool valid_offsets(const uint64_t* offsets, uint64_t size, uint64_t end) {
+  if (offsets[0] != 0 || offsets[size] != end) {
+    return false;
+  }
+  for (uint64_t i = 0; i < size; i++) {
+    if (offsets[i] > offsets[i + 1]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+Reader::Reader(const string& filename) : mapping(new Mapping(filename)) {
+  const auto invalid = [&]() {
+    return runtime_error(filename + " is not a valid geometry file");
+  };
+  if (mapping->size() < sizeof(Header)) {
+    throw invalid();
+  }
+  Header header;
+  std::memcpy(&header, mapping->data(), sizeof(header));
+  if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+    throw invalid();
+  }
+  if (header.version != FORMAT_VERSION) {
+    throw runtime_error(filename + " is a geometry file of an unsupported version");
+  }
+  if (header.byte_order != BYTE_ORDER_MARK) {
+    throw runtime_error(filename + " is a geometry file from a machine with another byte order");
+  }
+  kind_ = static_cast<Kind>(header.kind);
+  if (kind_ != Kind::MULTI_POLYGON && kind_ != Kind::MULTI_LINESTRING) {
+    throw invalid();
+  }
+  if (kind_ == Kind::MULTI_LINESTRING && header.polygon_count != 0) {
+    throw invalid();
+  }
+  // Check the counts against the size before multiplying so that nothing
+  // overflows.
+  const uint64_t words = (mapping->size() - sizeof(Header)) / 8;
+  const uint64_t polygon_table = kind_ == Kind::MULTI_POLYGON ? header.polygon_count + 1 : 0;
+  if (header.polygon_count >= words || header.ring_count >= words || header.point_count > words / 2 ||
+      (mapping->size() - sizeof(Header)) % 8 != 0 ||
+      polygon_table + header.ring_count + 1 + header.point_count * 2 != words) {
+    throw invalid();
+  }
+  polygon_count_ = header.polygon_count;
+  ring_count_ = header.ring_count;
+  point_count_ = header.point_count;
+  polygon_offsets = reinterpret_cast<const uint64_t*>(mapping->data() + sizeof(Header));
+  ring_offsets = polygon_offsets + polygon_table;
+  coordinates = reinterpret_cast<const double*>(ring_offsets + ring_count_ + 1);
+  if ((polygon_table > 0 && !valid_offsets(polygon_offsets, polygon_count_, ring_count_)) ||
+      !valid_offsets(ring_offsets, ring_count_, point_count_)) {
+    throw invalid();
+  }
+  for (size_t polygon = 0; polygon < polygon_count_; polygon++) {
+    if (first_ring(polygon) == first_ring(polygon + 1)) {
+      throw invalid();  // No outer ring.
+    }
+  }
+}
+
+Reader::~Reader() {}
+
+template <typename Points>
+static void copy_points(const geometry_file::Points& from, Points& to) {
+  to.reserve(from.size());
+  for (size_t i = 0; i < from.size(); i++) {
+    to.push_back(from[i]);
+  }
+}
+
+multi_polygon_type_fp Reader::multi_polygon() const {
+  if (kind_ != Kind::MULTI_POLYGON) {
+    throw runtime_error("The geometry file holds linestrings, not polygons");
+  }
+  multi_polygon_type_fp mp;
+  mp.resize(polygon_count_);
+  for (size_t polygon = 0; polygon < polygon_count_; polygon++) {
+    copy_points(ring(first_ring(polygon)), mp[polygon].outer());
+    mp[polygon].inners().resize(first_ring(polygon + 1) - first_ring(polygon) - 1);
+    for (size_t inner = 0; inner < mp[polygon].inners().size(); inner++) {
+      copy_points(ring(first_ring(polygon) + 1 + inner), mp[polygon].inners()[inner]);
+    }
+  }
+  return mp;
+}
+
+multi_linestring_type_fp Reader::multi_linestring() const {
+  if (kind_ != Kind::MULTI_LINESTRING) {
+    throw runtime_error("The geometry file holds polygons, not linestrings");
+  }
+  multi_linestring_type_fp mls;
+  mls.resize(ring_count_);
+  for (size_t i = 0; i < ring_count_; i++) {
+    copy_points(ring(i), mls[i]);
+  }
+  return mls;
+}
+
+} // namespace geometry_file
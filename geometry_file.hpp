@@ -0,0 +1,91 @@
+#ifndef GEOMETRY_FILE_HPP
+#define GEOMETRY_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "geometry.hpp"
+
+namespace geometry_file {
+
+// A binary file holding a multi_polygon or a multi_linestring, for saving
+// geometry that is too large to be handled quickly as WKT.  After a fixed
+// header, there are tables of offsets and then all the coordinates in one
+// flat array:
+//
+//   header
+//   uint64 polygon_offsets[polygons + 1]  index of each polygon's first ring
+//   uint64 ring_offsets[rings + 1]        index of each ring's first point
+//   double coordinates[points * 2]        x and y of each point
+//
+// For a multi_linestring, there are no polygons and each linestring is a
+// "ring".  Everything is in the byte order of the machine that wrote it,
+// which is recorded in the header, and aligned to 8 bytes so that a mapped
+// file can be read in place.
+
+enum class Kind : uint32_t { MULTI_POLYGON = 1, MULTI_LINESTRING = 2 };
+
+// Throws std::runtime_error if the file can't be written.
+void write(const std::string& filename, const multi_polygon_type_fp& mp);
+void write(const std::string& filename, const multi_linestring_type_fp& mls);
+
+// Whether the file starts like a geometry file.
+bool is_geometry_file(const std::string& filename);
+
+// The points of one ring or linestring, pointing into the file's contents.
+class Points {
+ public:
+  Points(const double* coordinates, size_t size) : coordinates(coordinates), size_(size) {}
+  size_t size() const { return size_; }
+  double x(size_t i) const { return coordinates[i * 2]; }
+  double y(size_t i) const { return coordinates[i * 2 + 1]; }
+  point_type_fp operator[](size_t i) const { return point_type_fp(x(i), y(i)); }
+
+ private:
+  const double* coordinates;
+  size_t size_;
+};
+
+// A geometry file, mapped into memory.  The rings are read from the file as
+// they are needed, without copying.  Throws std::runtime_error if the file
+// can't be read or isn't a valid geometry file.
+class Reader {
+ public:
+  explicit Reader(const std::string& filename);
+  ~Reader();
+  Reader(const Reader&) = delete;
+  Reader& operator=(const Reader&) = delete;
+
+  Kind kind() const { return kind_; }
+  size_t polygon_count() const { return polygon_count_; }
+  size_t ring_count() const { return ring_count_; }
+  size_t point_count() const { return point_count_; }
+  // The rings of polygon p are ring(first_ring(p)) to ring(first_ring(p+1)-1).
+  // The first is the outer ring.
+  size_t first_ring(size_t polygon) const { return polygon_offsets[polygon]; }
+  Points ring(size_t ring) const {
+    return Points(coordinates + ring_offsets[ring] * 2, ring_offsets[ring + 1] - ring_offsets[ring]);
+  }
+
+  // Copies of the whole contents.  Throws std::runtime_error if the file is
+  // of the other kind.
+  multi_polygon_type_fp multi_polygon() const;
+  multi_linestring_type_fp multi_linestring() const;
+
+ private:
+  class Mapping;
+  std::unique_ptr<Mapping> mapping;
+  Kind kind_;
+  size_t polygon_count_;
+  size_t ring_count_;
+  size_t point_count_;
+  const uint64_t* polygon_offsets;
+  const uint64_t* ring_offsets;
+  const double* coordinates;
+};
+
+} // namespace geometry_file
+
+#endif // GEOMETRY_FILE_HPP
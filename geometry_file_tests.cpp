@@ -0,0 +1,121 @@
+#define BOOST_TEST_MODULE geometry file tests
+#include <boost/test/unit_test.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#include <boost/lexical_cast.hpp>
+
+#include "geometry_file.hpp"
+
+using geometry_file::Kind;
+using geometry_file::Reader;
+
+BOOST_AUTO_TEST_SUITE(geometry_file_tests)
+
+const std::string filename = "geometry_file_tests_output.bin";
+
+template <typename T>
+static std::string wkt(const T& geometry) {
+  return boost::lexical_cast<std::string>(bg::wkt(geometry));
+}
+
+static std::string read_contents() {
+  std::ifstream in(filename, std::ios::binary);
+  return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+static void write_contents(const std::string& contents) {
+  std::ofstream(filename, std::ios::binary | std::ios::trunc) << contents;
+}
+
+BOOST_AUTO_TEST_CASE(multi_polygon) {
+  multi_polygon_type_fp mp;
+  bg::read_wkt("MULTIPOLYGON(((0 0,0 10,10 10,10 0,0 0),(2 2,8 2,8 8,2 8,2 2),(1 1,1.5 1,1.5 1.5,1 1)),"
+               "((20 0,20 1,21 1,20 0)))", mp);
+  geometry_file::write(filename, mp);
+  BOOST_CHECK(geometry_file::is_geometry_file(filename));
+  const Reader reader(filename);
+  BOOST_CHECK(reader.kind() == Kind::MULTI_POLYGON);
+  BOOST_CHECK_EQUAL(reader.polygon_count(), 2);
+  BOOST_CHECK_EQUAL(reader.ring_count(), 4);
+  BOOST_CHECK_EQUAL(reader.point_count(), bg::num_points(mp));
+  BOOST_CHECK_EQUAL(reader.first_ring(1), 3);
+  BOOST_CHECK_EQUAL(reader.ring(1).size(), 5);
+  BOOST_CHECK_EQUAL(reader.ring(1).x(2), 8);
+  BOOST_CHECK_EQUAL(reader.ring(1).y(2), 8);
+  BOOST_CHECK_EQUAL(wkt(reader.multi_polygon()), wkt(mp));
+  BOOST_CHECK_THROW(reader.multi_linestring(), std::runtime_error);
+  std::remove(filename.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(multi_linestring) {
+  multi_linestring_type_fp mls;
+  bg::read_wkt("MULTILINESTRING((0 0,1 1,2 0),(5 5,6 6),(0.1 0.2,0.3 0.4,1e-300 1e300))", mls);
+  geometry_file::write(filename, mls);
+  const Reader reader(filename);
+  BOOST_CHECK(reader.kind() == Kind::MULTI_LINESTRING);
+  BOOST_CHECK_EQUAL(reader.polygon_count(), 0);
+  BOOST_CHECK_EQUAL(reader.ring_count(), 3);
+  const auto loaded = reader.multi_linestring();
+  BOOST_REQUIRE_EQUAL(loaded.size(), 3);
+  // The coordinates are stored exactly.
+  for (size_t i = 0; i < mls.size(); i++) {
+    BOOST_REQUIRE_EQUAL(loaded[i].size(), mls[i].size());
+    for (size_t j = 0; j < mls[i].size(); j++) {
+      BOOST_CHECK_EQUAL(loaded[i][j].x(), mls[i][j].x());
+      BOOST_CHECK_EQUAL(loaded[i][j].y(), mls[i][j].y());
+    }
+  }
+  BOOST_CHECK_THROW(reader.multi_polygon(), std::runtime_error);
+  std::remove(filename.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(empty) {
+  geometry_file::write(filename, multi_polygon_type_fp{});
+  BOOST_CHECK(Reader(filename).multi_polygon().empty());
+  geometry_file::write(filename, multi_linestring_type_fp{});
+  BOOST_CHECK(Reader(filename).multi_linestring().empty());
+  std::remove(filename.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(invalid) {
+  BOOST_CHECK(!geometry_file::is_geometry_file("no_such_file.bin"));
+  BOOST_CHECK_THROW(Reader("no_such_file.bin"), std::runtime_error);
+  write_contents("MULTIPOLYGON(((0 0,0 1,1 1,1 0,0 0)))");
+  BOOST_CHECK(!geometry_file::is_geometry_file(filename));
+  BOOST_CHECK_THROW(Reader{filename}, std::runtime_error);
+
+  multi_polygon_type_fp mp;
+  bg::read_wkt("MULTIPOLYGON(((0 0,0 1,1 1,1 0,0 0)))", mp);
+  geometry_file::write(filename, mp);
+  const std::string contents = read_contents();
+  // Cut short.
+  write_contents(contents.substr(0, contents.size() - 8));
+  BOOST_CHECK_THROW(Reader{filename}, std::runtime_error);
+  write_contents(contents.substr(0, 20));
+  BOOST_CHECK_THROW(Reader{filename}, std::runtime_error);
+  // A huge point count.
+  std::string corrupt = contents;
+  corrupt.replace(40, 8, std::string(8, '\xff'));
+  write_contents(corrupt);
+  BOOST_CHECK_THROW(Reader{filename}, std::runtime_error);
+  // A ring offset past the end of the points.
+  corrupt = contents;
+  corrupt[48 + 2 * 8 + 8] = 6;
+  write_contents(corrupt);
+  BOOST_CHECK_THROW(Reader{filename}, std::runtime_error);
+  // The other byte order.
+  corrupt = contents;
+  std::swap(corrupt[16], corrupt[19]);
+  std::swap(corrupt[17], corrupt[18]);
+  write_contents(corrupt);
+  BOOST_CHECK_THROW(Reader{filename}, std::runtime_error);
+  write_contents(contents);
+  BOOST_CHECK_NO_THROW(Reader{filename});
+  std::remove(filename.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -50,12 +50,14 @@ using std::forward_list;
 using std::map;
 
 #include <boost/format.hpp>
+#include <boost/geometry/index/rtree.hpp>
 
 #include "gerberimporter.hpp"
 #include "eulerian_paths.hpp"
 #include "bg_operators.hpp"
 #include "bg_helpers.hpp"
 #include "merge_near_points.hpp"
+#include "precision.hpp"
 
 namespace bg = boost::geometry;
 
@@ -73,6 +75,7 @@ GerberImporter::~GerberImporter() {
 
 /* Returns true iff successful. */
 bool GerberImporter::load_file(const string& path) {
+  filename = path;
   gchar *filename = g_strdup(path.c_str());
   gerbv_open_layer_from_filename(project, filename);
   g_free(filename);
@@ -109,7 +112,7 @@ multi_polygon_type_fp make_regular_polygon(point_type_fp center, coordinate_type
 
 // Uses make_regular_polygon to draw a circle of line segments.
 multi_polygon_type_fp GerberImporter::make_circle(point_type_fp center, coordinate_type_fp diameter, coordinate_type_fp offset) const {
-  const auto points_per_circle = std::max(32., diameter * bg::math::pi<double>() / max_arc_segment_length);
+  const auto points_per_circle = precision::points_per_circle(diameter / 2, max_arc_segment_length);
   return ::make_regular_polygon(center, diameter, points_per_circle, offset);
 }
 
@@ -195,7 +198,7 @@ multi_polygon_type_fp GerberImporter::make_oval(point_type_fp center, coordinate
   line.push_back(start);
   line.push_back(end);
   const auto diameter = std::max(width, height); // Close enough.
-  const auto circle_points = std::max(32., diameter * bg::math::pi<double>() / max_arc_segment_length);
+  const auto circle_points = precision::points_per_circle(diameter / 2, max_arc_segment_length);
   bg::buffer(line, oval,
              bg::strategy::buffer::distance_symmetric<coordinate_type_fp>(std::min(width, height)/2),
              bg::strategy::buffer::side_straight(),
@@ -296,7 +299,7 @@ linestring_type_fp GerberImporter::circular_arc(const point_type_fp& start, cons
   const coordinate_type_fp start_radius = bg::distance(start, center);
   const coordinate_type_fp stop_radius = bg::distance(stop, center);
   auto const average_radius = (start_radius + stop_radius) / 2;
-  auto const radius_points = std::max(32. / 2 / bg::math::pi<double>(), average_radius / max_arc_segment_length);
+  auto const radius_points = precision::points_per_radian(average_radius, max_arc_segment_length);
   const unsigned int steps = std::ceil(std::abs(delta_angle) * radius_points) + 1; // One more for the end point.
   linestring_type_fp linestring;
   linestring.reserve(steps);
@@ -338,23 +341,148 @@ struct mp_pair {
   multi_polygon_type_fp filled_closed_lines;
 };
 
+// A flash of an aperture, kept as a reference to the aperture in
+// apertures_map until the layer is merged.
+struct aperture_flash {
+  aperture_flash(int aperture, point_type_fp offset) :
+    aperture(aperture),
+    offset(offset) {}
+  int aperture;
+  point_type_fp offset;
+};
+
+// The draws and the flashes of one layer.
+struct layer_draws {
+  layer_draws() {}
+  layer_draws(const gerbv_layer_t *layer) : layer(layer) {}
+  const gerbv_layer_t *layer = nullptr;
+  vector<mp_pair> draws;
+  vector<aperture_flash> flashes;
+};
+
 // To speed up the merging, we do them in pairs so that we're mostly merging
-// equal-sized shapes.
-mp_pair merge_multi_draws(const vector<mp_pair>& multi_draws) {
-  if (multi_draws.size() == 0) {
-    return multi_polygon_type_fp();
-  } else if (multi_draws.size() == 1) {
-    return multi_draws.front();
-  }
+// equal-sized shapes.  Flashes whose envelope doesn't touch any other flash
+// or draw can't change the union so they are added as they are.  Only the
+// rest go into the union.
+mp_pair merge_multi_draws(const vector<mp_pair>& multi_draws,
+                          const vector<aperture_flash>& flashes,
+                          const map<int, multi_polygon_type_fp>& apertures_map) {
   vector<multi_polygon_type_fp> shapes;
   vector<multi_polygon_type_fp> filled_closed_lines;
-  shapes.reserve(multi_draws.size());
+  shapes.reserve(multi_draws.size() + flashes.size());
   filled_closed_lines.reserve(multi_draws.size());
   for (const auto& multi_draw : multi_draws) {
     shapes.push_back(multi_draw.shapes);
     filled_closed_lines.push_back(multi_draw.filled_closed_lines);
   }
-  return mp_pair(sum(shapes), symdiff(filled_closed_lines));
+  multi_polygon_type_fp isolated_flashes;
+  if (flashes.size() > 0) {
+    map<int, box_type_fp> aperture_envelopes;
+    for (const auto& aperture : apertures_map) {
+      aperture_envelopes[aperture.first] = bg::return_envelope<box_type_fp>(aperture.second);
+    }
+    // The flashes are numbered first and then each polygon in the draws.
+    vector<std::pair<box_type_fp, size_t>> envelopes;
+    for (const auto& flash : flashes) {
+      box_type_fp envelope;
+      bg::transform(aperture_envelopes.at(flash.aperture), envelope,
+                    translate(flash.offset.x(), flash.offset.y()));
+      envelopes.emplace_back(envelope, envelopes.size());
+    }
+    for (const auto& multi_draw : multi_draws) {
+      for (const auto& poly : multi_draw.shapes) {
+        envelopes.emplace_back(bg::return_envelope<box_type_fp>(poly), envelopes.size());
+      }
+    }
+    const bg::index::rtree<std::pair<box_type_fp, size_t>, bg::index::rstar<16>> tree(envelopes);
+    for (size_t i = 0; i < flashes.size(); i++) {
+      const auto& flash = flashes[i];
+      multi_polygon_type_fp mpoly;
+      bg::transform(apertures_map.at(flash.aperture), mpoly,
+                    translate(flash.offset.x(), flash.offset.y()));
+      const auto& envelope = envelopes[i].first;
+      const bool isolated = std::none_of(
+          tree.qbegin(bg::index::intersects(envelope)), tree.qend(),
+          [i](const std::pair<box_type_fp, size_t>& other) { return other.second != i; });
+      if (isolated) {
+        isolated_flashes.insert(isolated_flashes.cend(), mpoly.cbegin(), mpoly.cend());
+      } else {
+        shapes.push_back(mpoly);
+      }
+    }
+  }
+  auto merged_shapes = sum(shapes);
+  merged_shapes.insert(merged_shapes.cend(), isolated_flashes.cbegin(), isolated_flashes.cend());
+  return mp_pair(merged_shapes, symdiff(filled_closed_lines));
+}
+
+// Tile draws over the step-and-repeat grid.  Two copies can only overlap
+// where their envelopes do, so only the polygons that reach into the
+// envelope of a neighbouring copy need to be unioned.  All the rest are
+// translated and concatenated.  In the common case of a panel with a pitch
+// larger than the envelope, that's all of them.
+multi_polygon_type_fp step_and_repeat(const multi_polygon_type_fp& draws,
+                                      const gerbv_step_and_repeat_t& stepAndRepeat) {
+  if (draws.size() == 0 || stepAndRepeat.X <= 0 || stepAndRepeat.Y <= 0) {
+    return draws;
+  }
+  const auto envelope = bg::return_envelope<box_type_fp>(draws);
+  // Offsets from one copy to another for which the envelopes intersect.
+  vector<point_type_fp> neighbor_offsets;
+  for (int sr_x = 1 - stepAndRepeat.X; sr_x < stepAndRepeat.X; sr_x++) {
+    for (int sr_y = 1 - stepAndRepeat.Y; sr_y < stepAndRepeat.Y; sr_y++) {
+      if (sr_x == 0 && sr_y == 0) {
+        continue;
+      }
+      const point_type_fp offset(stepAndRepeat.dist_X * sr_x, stepAndRepeat.dist_Y * sr_y);
+      box_type_fp neighbor_envelope;
+      bg::transform(envelope, neighbor_envelope, translate(offset.x(), offset.y()));
+      if (bg::intersects(envelope, neighbor_envelope)) {
+        neighbor_offsets.push_back(offset);
+      }
+    }
+  }
+  // Split the polygons into those that might touch another copy and those
+  // that can't.
+  multi_polygon_type_fp seams;
+  multi_polygon_type_fp isolated;
+  for (const auto& poly : draws) {
+    const auto poly_envelope = bg::return_envelope<box_type_fp>(poly);
+    bool is_seam = false;
+    for (const auto& offset : neighbor_offsets) {
+      box_type_fp neighbor_envelope;
+      bg::transform(envelope, neighbor_envelope, translate(offset.x(), offset.y()));
+      if (bg::intersects(poly_envelope, neighbor_envelope)) {
+        is_seam = true;
+        break;
+      }
+    }
+    (is_seam ? seams : isolated).push_back(poly);
+  }
+
+  multi_polygon_type_fp ret;
+  vector<multi_polygon_type_fp> to_sum;
+  ret.reserve(isolated.size() * stepAndRepeat.X * stepAndRepeat.Y);
+  to_sum.reserve(stepAndRepeat.X * stepAndRepeat.Y);
+  for (int sr_x = 0; sr_x < stepAndRepeat.X; sr_x++) {
+    for (int sr_y = 0; sr_y < stepAndRepeat.Y; sr_y++) {
+      const translate offset(stepAndRepeat.dist_X * sr_x,
+                             stepAndRepeat.dist_Y * sr_y);
+      multi_polygon_type_fp translated_draws;
+      bg::transform(isolated, translated_draws, offset);
+      ret.insert(ret.cend(), translated_draws.cbegin(), translated_draws.cend());
+      if (seams.size() > 0) {
+        multi_polygon_type_fp translated_seams;
+        bg::transform(seams, translated_seams, offset);
+        to_sum.push_back(translated_seams);
+      }
+    }
+  }
+  if (to_sum.size() > 0) {
+    const auto summed_seams = sum(to_sum);
+    ret.insert(ret.cend(), summed_seams.cbegin(), summed_seams.cend());
+  }
+  return ret;
 }
 
 // layers is a vector of layers.  Each layer has a polarity, which can
@@ -378,22 +506,7 @@ multi_polygon_type_fp generate_layers(vector<pair<const gerbv_layer_t *, mp_pair
     mp_pair draw_pair = layer->second;
     multi_polygon_type_fp draws = draw_pair.*member;
     if (stepAndRepeat.X > 0 || stepAndRepeat.Y > 0) {
-      vector<multi_polygon_type_fp> to_sum{draws};
-
-      to_sum.reserve(stepAndRepeat.X * stepAndRepeat.Y);
-      for (int sr_x = 0; sr_x < stepAndRepeat.X; sr_x++) {
-        for (int sr_y = 0; sr_y < stepAndRepeat.Y; sr_y++) {
-          if (sr_x == 0 && sr_y == 0) {
-            continue; // Already got this one.
-          }
-          multi_polygon_type_fp translated_draws;
-          bg::transform(draws, translated_draws,
-                        translate(stepAndRepeat.dist_X * sr_x,
-                                  stepAndRepeat.dist_Y * sr_y));
-          to_sum.push_back(translated_draws);
-        }
-      }
-      draws = sum(to_sum);
+      draws = step_and_repeat(draws, stepAndRepeat);
     }
 
     if (xor_layers) {
@@ -713,17 +826,18 @@ mp_pair paths_to_shapes(const coordinate_type_fp& diameter, const multi_linestri
   }
   mp_pair ovals;
   if (fill_closed_lines) {
+    vector<multi_polygon_type_fp> loops;
     for (auto& euler_path : euler_paths) {
       if (bg::equals(euler_path.front(), euler_path.back())) {
         // This is a loop.
         polygon_type_fp loop_poly;
         loop_poly.outer().swap(euler_path);
         bg::correct(loop_poly);
-        multi_polygon_type_fp loop_mpoly;
-        loop_mpoly.push_back(loop_poly);
-        ovals.filled_closed_lines = ovals.filled_closed_lines ^ loop_mpoly;
+        loops.push_back(multi_polygon_type_fp{loop_poly});
       }
     }
+    // All the loops are xor-ed together in a single pass.
+    ovals.filled_closed_lines = symdiff(loops);
   }
   euler_paths.erase(std::remove_if(euler_paths.begin(), euler_paths.end(), [](const linestring_type_fp& l) { return l.size() == 0; }), euler_paths.end());
   if (euler_paths.size() > 0) {
@@ -742,6 +856,19 @@ mp_pair paths_to_shapes(const coordinate_type_fp& diameter, const multi_linestri
 }
 
 
+// Add path to paths.  If the last path in paths ends where this one starts,
+// extend it instead of starting a new one.  Gerber files draw traces as many
+// short segments that mostly follow on from one another so this saves making
+// a linestring for each one.  The paths are split at all the junctions later,
+// when making eulerian paths, so joining them here doesn't change the output.
+void append_path(multi_linestring_type_fp& paths, const linestring_type_fp& path) {
+  if (paths.size() > 0 && paths.back().back() == path.front()) {
+    paths.back().insert(paths.back().cend(), path.cbegin() + 1, path.cend());
+  } else {
+    paths.push_back(path);
+  }
+}
+
 // Convert the gerber file into a pair of multi_polygon_type_fp and a list of
 // linear_paths.  The linear paths are a map from diamter of the tool for the
 // path to all the paths at that diameter.  If fill_closed_lines is true, return
@@ -752,7 +879,7 @@ pair<multi_polygon_type_fp, map<coordinate_type_fp, multi_linestring_type_fp>> G
   ring_type_fp region;
   bool contour = false; // Are we in contour mode?
 
-  vector<pair<const gerbv_layer_t *, vector<mp_pair>>> layers(1);
+  vector<layer_draws> layers(1);
 
   gerbv_image_t *gerber = project->file[0]->image;
 
@@ -761,7 +888,7 @@ pair<multi_polygon_type_fp, map<coordinate_type_fp, multi_linestring_type_fp>> G
   }
 
   const map<int, multi_polygon_type_fp> apertures_map = generate_apertures_map(gerber->aperture);
-  layers.front().first = gerber->netlist->layer;
+  layers.front().layer = gerber->netlist->layer;
 
 
   map<coordinate_type_fp, multi_linestring_type_fp> linear_circular_paths;
@@ -771,19 +898,18 @@ pair<multi_polygon_type_fp, map<coordinate_type_fp, multi_linestring_type_fp>> G
     const double * const parameters = gerber->aperture[currentNet->aperture]->parameter;
     multi_polygon_type_fp mpoly;
 
-    if (!layers_equivalent(currentNet->layer, layers.back().first)) {
+    if (!layers_equivalent(currentNet->layer, layers.back().layer)) {
       if (render_paths_to_shapes) {
         // About to start a new layer, render all the linear_circular_paths so far.
         for (const auto& diameter_and_path : linear_circular_paths) {
-          layers.back().second.push_back(paths_to_shapes(diameter_and_path.first, diameter_and_path.second, fill_closed_lines));
+          layers.back().draws.push_back(paths_to_shapes(diameter_and_path.first, diameter_and_path.second, fill_closed_lines));
         }
         linear_circular_paths.clear();
       }
-      layers.resize(layers.size() + 1);
-      layers.back().first = currentNet->layer;
+      layers.emplace_back(currentNet->layer);
     }
 
-    vector<mp_pair>& draws = layers.back().second;
+    vector<mp_pair>& draws = layers.back().draws;
 
     if (currentNet->interpolation == GERBV_INTERPOLATION_LINEARx1) {
       if (currentNet->aperture_state == GERBV_APERTURE_STATE_ON) {
@@ -797,10 +923,7 @@ pair<multi_polygon_type_fp, map<coordinate_type_fp, multi_linestring_type_fp>> G
             // These are common and too slow to merge one by one so we put them
             // all together and then do one big union at the end.
             const double diameter = parameters[0];
-            linestring_type_fp segment;
-            segment.push_back(start);
-            segment.push_back(stop);
-            linear_circular_paths[diameter].push_back(segment);
+            append_path(linear_circular_paths[diameter], {start, stop});
           } else if (gerber->aperture[currentNet->aperture]->type == GERBV_APTYPE_RECTANGLE) {
             mpoly = linear_draw_rectangular_aperture(start, stop, parameters[0],
                                                      parameters[1]);
@@ -816,15 +939,14 @@ pair<multi_polygon_type_fp, map<coordinate_type_fp, multi_linestring_type_fp>> G
           cerr << ("D03 during contour mode is forbidden by the Gerber "
                    "standard; skipping") << endl;
         } else {
-          const auto aperture_mpoly = apertures_map.find(currentNet->aperture);
-
-          if (aperture_mpoly != apertures_map.end()) {
-            bg::transform(aperture_mpoly->second, mpoly, translate(stop.x(), stop.y()));
+          if (apertures_map.count(currentNet->aperture) > 0) {
+            // Flashes are translated copies of the aperture so they are only
+            // instantiated when the layer is merged.
+            layers.back().flashes.emplace_back(currentNet->aperture, stop);
           } else {
             cerr << "Macro aperture " << currentNet->aperture <<
                 " not found in macros list; skipping" << endl;
           }
-          draws.push_back(mpoly);
         }
       } else if (currentNet->aperture_state == GERBV_APERTURE_STATE_OFF) {
         if (contour) {
@@ -872,12 +994,7 @@ pair<multi_polygon_type_fp, map<coordinate_type_fp, multi_linestring_type_fp>> G
           } else {
             if (gerber->aperture[currentNet->aperture]->type == GERBV_APTYPE_CIRCLE) {
               const double diameter = parameters[0];
-              for (size_t i = 1; i < path.size(); i++) {
-                linestring_type_fp segment;
-                segment.push_back(path[i-1]);
-                segment.push_back(path[i]);
-                linear_circular_paths[diameter].push_back(segment);
-              }
+              append_path(linear_circular_paths[diameter], path);
             } else {
               cerr << ("Drawing an arc with an aperture different from a circle "
                        "is forbidden by the Gerber standard; skipping.")
@@ -903,14 +1020,14 @@ pair<multi_polygon_type_fp, map<coordinate_type_fp, multi_linestring_type_fp>> G
   if (render_paths_to_shapes) {
     // If there are any unrendered circular paths, add them to the last layer.
     for (const auto& diameter_and_path : linear_circular_paths) {
-      layers.back().second.push_back(paths_to_shapes(diameter_and_path.first, diameter_and_path.second, fill_closed_lines));
+      layers.back().draws.push_back(paths_to_shapes(diameter_and_path.first, diameter_and_path.second, fill_closed_lines));
     }
     linear_circular_paths.clear();
   }
   vector<pair<const gerbv_layer_t *, mp_pair>> merged_layers;
   merged_layers.reserve(layers.size());
   for (const auto& layer : layers) {
-    merged_layers.emplace_back(layer.first, merge_multi_draws(layer.second));
+    merged_layers.emplace_back(layer.layer, merge_multi_draws(layer.draws, layer.flashes, apertures_map));
   }
   auto result = generate_layers(merged_layers, &mp_pair::filled_closed_lines, fill_closed_lines);
   if (fill_closed_lines) {
@@ -62,6 +62,12 @@ public:
   const gerbv_project_t* get_project() const {
     return project;
   }
+  const std::string& get_filename() const {
+    return filename;
+  }
+  coordinate_type_fp get_max_arc_segment_length() const {
+    return max_arc_segment_length;
+  }
 
 protected:
   enum Side { FRONT = 0, BACK = 1 } side;
@@ -86,6 +92,7 @@ private:
   std::map<int, multi_polygon_type_fp> generate_apertures_map(const gerbv_aperture_t * const apertures[]) const;
   coordinate_type_fp const max_arc_segment_length;
   gerbv_project_t* project;
+  std::string filename;
 };
 
 #endif // GERBERIMPORTER_H
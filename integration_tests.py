@@ -7,13 +7,16 @@ import argparse
 import collections
 import difflib
 import filecmp
+import json
 import multiprocessing
 import os
 import re
 import shutil
+import statistics
 import subprocess
 import sys
 import tempfile
+import time
 import xml.etree.ElementTree
 
 import colour_runner.runner
@@ -327,6 +330,121 @@ class IntegrationTests(unittest.TestCase):
 def cmp(x,y):
   return (x>y) - (x<y)
 
+def measure_one(test_case, cwd, runs):
+  """Run pcb2gcode on a test case a few times and measure it.
+
+  Returns the median wall time and CPU time in seconds, the peak memory in
+  kilobytes and the median time of each stage that pcb2gcode reports with
+  --report-stats.  The peak memory can't be less than what this script was
+  using when it started pcb2gcode.
+  """
+  pcb2gcode = os.path.join(cwd, "pcb2gcode")
+  input_path = os.path.join(cwd, test_case.input_path)
+  wall_times = []
+  cpu_times = []
+  peak_memory = 0
+  stages = collections.defaultdict(list)
+  for _ in range(runs):
+    actual_output_path = tempfile.mkdtemp()
+    try:
+      cmd = [pcb2gcode]
+      if not any("output-dir" in x for x in test_case.args):
+        cmd += ["--output-dir", actual_output_path]
+      cmd += test_case.args + ["--report-stats"]
+      with tempfile.TemporaryFile() as output:
+        start = time.perf_counter()
+        proc = subprocess.Popen(cmd, cwd=input_path, stdout=output, stderr=subprocess.STDOUT)
+        _, status, usage = os.wait4(proc.pid, 0)
+        wall_times.append(time.perf_counter() - start)
+        proc.returncode = os.WEXITSTATUS(status) if os.WIFEXITED(status) else -1
+        output.seek(0)
+        text = output.read().decode(errors="replace")
+    finally:
+      shutil.rmtree(actual_output_path)
+    if proc.returncode != test_case.exit_code:
+      raise RuntimeError("Running {} exited with {}:\n{}".format(cmd, proc.returncode, text))
+    cpu_times.append(usage.ru_utime + usage.ru_stime)
+    peak_memory = max(peak_memory, usage.ru_maxrss)
+    for match in re.finditer(r"^(.*) microseconds: (\d+)$", text, re.MULTILINE):
+      stages[match.group(1)].append(int(match.group(2)) / 1e6)
+  return {"wall_seconds": statistics.median(wall_times),
+          "cpu_seconds": statistics.median(cpu_times),
+          "peak_memory_kb": peak_memory,
+          "stages": {name: statistics.median(times) for name, times in stages.items()}}
+
+def compare_to_baseline(result, baseline, args):
+  """Returns a description of each way that the result is worse than the baseline.
+
+  Small differences are ignored because they are usually just noise.
+  """
+  regressions = []
+  for key, threshold, minimum in (("wall_seconds", args.perf_time_threshold, args.perf_min_seconds),
+                                  ("cpu_seconds", args.perf_time_threshold, args.perf_min_seconds),
+                                  ("peak_memory_kb", args.perf_memory_threshold, args.perf_min_memory_kb)):
+    if key not in baseline:
+      continue
+    if result[key] > baseline[key] * (1 + threshold) and result[key] - baseline[key] > minimum:
+      regressions.append("{} went from {:.6g} to {:.6g} ({:+.0%})".format(
+          key, baseline[key], result[key], result[key] / baseline[key] - 1))
+  return regressions
+
+def slowest_stages(result, baseline, count=5):
+  """Describe the stages that took the most time, compared to the baseline."""
+  lines = []
+  for name, seconds in sorted(result["stages"].items(), key=lambda x: -x[1])[:count]:
+    line = "    {}: {:.3f}s".format(name, seconds)
+    if name in baseline.get("stages", {}):
+      line += " (was {:.3f}s)".format(baseline["stages"][name])
+    lines.append(line)
+  return lines
+
+def run_perf(args, cwd):
+  """Measure each example that should succeed and compare it to the baseline.
+
+  With --perf-update, the baseline is updated instead.  Returns the exit code,
+  which is non-zero if there is nothing to compare to.
+  """
+  baseline_path = os.path.join(cwd, args.perf_baseline)
+  baseline = {}
+  if os.path.exists(baseline_path):
+    with open(baseline_path) as baseline_file:
+      baseline = json.load(baseline_file)["examples"]
+  elif not args.perf_update:
+    print("No baseline in {}, run with --perf-update to make one.".format(baseline_path))
+    return 1
+  results = {}
+  regressed = []
+  for test_case in TEST_CASES:
+    if test_case.exit_code != 0 or "--version" in test_case.args or "--help" in test_case.args:
+      continue
+    result = measure_one(test_case, cwd, args.perf_runs)
+    results[test_case.name] = result
+    print("{:<50} {:8.3f}s wall {:8.3f}s cpu {:8.1f}MB".format(
+        test_case.name, result["wall_seconds"], result["cpu_seconds"], result["peak_memory_kb"] / 1024))
+    if not args.perf_update and test_case.name in baseline:
+      regressions = compare_to_baseline(result, baseline[test_case.name], args)
+      if regressions:
+        regressed.append((test_case.name, regressions))
+  if args.perf_update:
+    baseline.update(results)
+    with open(baseline_path, "w") as baseline_file:
+      json.dump({"examples": baseline}, baseline_file, indent=2, sort_keys=True)
+      baseline_file.write("\n")
+    print("Wrote {}".format(baseline_path))
+    return 0
+  if not regressed:
+    return 0
+  print(colored("\n{} examples got slower or bigger:".format(len(regressed)), attrs=["bold"]))
+  for name, regressions in regressed:
+    print(colored(name, color="red"))
+    for regression in regressions:
+      print("  " + regression)
+    stages = slowest_stages(results[name], baseline[name])
+    if stages:
+      print("  Slowest stages:")
+      print("\n".join(stages))
+  return 1
+
 if __name__ == '__main__':
   parser = argparse.ArgumentParser(description='Integration test of pcb2gcode.')
   parser.add_argument('--fix', action='store_true', dest='fix',
@@ -340,10 +458,29 @@ if __name__ == '__main__':
                       help='number of threads for running tests concurrently')
   parser.add_argument('--tests', type=str, default="",
                       help='regex of tests to run')
+  parser.add_argument('--perf', action='store_true', default=False,
+                      help='measure the time and memory of each example instead of checking the '
+                      'outputs and compare them to the baseline')
+  parser.add_argument('--perf-update', action='store_true', default=False,
+                      help='with --perf, save the measurements as the baseline')
+  parser.add_argument('--perf-baseline', type=str, default="integration_tests_perf.json",
+                      help='JSON file with the baseline measurements')
+  parser.add_argument('--perf-runs', type=int, default=3,
+                      help='times to run each example, the median is used')
+  parser.add_argument('--perf-time-threshold', type=float, default=0.2,
+                      help='fraction by which the wall or CPU time may grow')
+  parser.add_argument('--perf-memory-threshold', type=float, default=0.2,
+                      help='fraction by which the peak memory may grow')
+  parser.add_argument('--perf-min-seconds', type=float, default=0.05,
+                      help='time differences smaller than this are ignored')
+  parser.add_argument('--perf-min-memory-kb', type=int, default=1024,
+                      help='memory differences smaller than this are ignored')
   args = parser.parse_args()
   if args.tests:
     TEST_CASES = [t for t in TEST_CASES if re.search(args.tests, t.name)]
   cwd = os.getcwd()
+  if args.perf:
+    exit(run_perf(args, cwd))
   def add_test_case(t):
     def test_method(self):
       self.do_test_one(t, cwd)
@@ -45,6 +45,11 @@ using std::string;
 #include "drill.hpp"
 #include "options.hpp"
 #include "units.hpp"
+#include "precision.hpp"
+#include "stats.hpp"
+#include "debug_output.hpp"
+#include "disk_cache.hpp"
+#include "stage_recorder.hpp"
 
 #include <boost/algorithm/string.hpp>
 #include <boost/version.hpp>
@@ -87,6 +92,12 @@ void do_pcb2gcode(int argc, const char* argv[]) {
     const bool ymirror = vm["mirror-yaxis"].as<bool>();
     const double tolerance = vm["tolerance"].as<double>() * unit;
     const bool explicit_tolerance = !vm["nog64"].as<bool>();
+    precision::set_max_deviation(vm["adaptive-circles"].as<bool>() ? tolerance : 0);
+    stats::enable(vm["report-stats"].as<bool>());
+    debug_output::set_level(vm["debug-output"].as<DebugOutput::DebugOutput>());
+    disk_cache::set_directory(vm["cache-dir"].as<string>(),
+                              uint64_t(vm["cache-size"].as<unsigned int>()) * 1024 * 1024);
+    stage_recorder::set_stage(vm["record-stage"].as<RecordStage::RecordStage>());
     const string outputdir = vm["output-dir"].as<string>();
     const double spindown_time = vm.count("spindown-time") ?
         vm["spindown-time"].as<Time>().asMillisecond(1) : vm["spinup-time"].as<Time>().asMillisecond(1);
@@ -116,11 +127,16 @@ void do_pcb2gcode(int argc, const char* argv[]) {
         isolator->optimise = vm["optimise"].as<Length>().asInch(unit);
         isolator->offset = vm["offset"].as<Length>().asInch(unit);
         isolator->preserve_thermal_reliefs = vm["preserve-thermal-reliefs"].as<bool>();
+        isolator->layer_offsets = vm["layer-offsets"].as<bool>();
+        isolator->draft_resolution = vm["draft-resolution"].as<Length>().asInch(unit);
+        isolator->voronoi_tiles = vm["voronoi-tiles"].as<unsigned int>();
+        isolator->simplify_voronoi = vm["simplify-voronoi"].as<bool>();
         isolator->eulerian_paths = vm["eulerian-paths"].as<bool>();
         isolator->path_finding_limit = vm["path-finding-limit"].as<size_t>();
         isolator->g0_vertical_speed = vm["g0-vertical-speed"].as<Velocity>().asInchPerMinute(unit);
         isolator->g0_horizontal_speed = vm["g0-horizontal-speed"].as<Velocity>().asInchPerMinute(unit);
         isolator->backtrack = vm["backtrack"].as<Velocity>().asInchPerMinute(unit);
+        isolator->arc_tolerance = vm["arc-tolerance"].as<Length>().asInch(unit);
         if (vm.count("mill-infeed")) {
           isolator->stepsize = vm["mill-infeed"].as<Length>().asInch(unit);
         } else {
@@ -158,6 +174,7 @@ void do_pcb2gcode(int argc, const char* argv[]) {
       cutter->path_finding_limit = vm["path-finding-limit"].as<size_t>();
       cutter->g0_vertical_speed = vm["g0-vertical-speed"].as<Velocity>().asInchPerMinute(unit);
       cutter->g0_horizontal_speed = vm["g0-horizontal-speed"].as<Velocity>().asInchPerMinute(unit);
+      cutter->arc_tolerance = vm["arc-tolerance"].as<Length>().asInch(unit);
       cutter->tolerance = tolerance;
       cutter->explicit_tolerance = explicit_tolerance;
       cutter->spinup_time = vm["spinup-time"].as<Time>().asMillisecond(1);
@@ -332,6 +349,7 @@ void do_pcb2gcode(int argc, const char* argv[]) {
         exporter->set_postamble(postamble);
       }
 
+      const stats::Timer timer("export microseconds");
       exporter->export_all(vm);
     }
 
@@ -414,6 +432,13 @@ void do_pcb2gcode(int argc, const char* argv[]) {
         cout << "not specified.\n";
     }
 
+    debug_output::finish();
+    disk_cache::trim();
+    if (stats::enabled()) {
+      cout << "Statistics:\n";
+      stats::report(cout);
+    }
+
     cout << "END." << endl;
 
 }
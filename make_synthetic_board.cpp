@@ -0,0 +1,78 @@
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+using std::string;
+
+#include "synthetic_board.hpp"
+
+// Writes a made up board of any size, for benchmarking pcb2gcode on boards
+// that are bigger than the examples.
+
+static void usage() {
+  const synthetic_board::Parameters defaults;
+  std::cerr << "Usage: make_synthetic_board [OPTION]... DIRECTORY" << std::endl
+            << "Writes the gerber and excellon files of a made up board and a millproject for" << std::endl
+            << "them to DIRECTORY.  The same options always make the same board." << std::endl
+            << std::endl
+            << "  --traces N          traces on each side (default " << defaults.traces << ")" << std::endl
+            << "  --pad-density F     fraction of the grid with pads apart from the ends of" << std::endl
+            << "                      the traces (default " << defaults.pad_density << ")" << std::endl
+            << "  --pour-fraction F   fraction of each side covered with copper pours" << std::endl
+            << "                      (default " << defaults.pour_fraction << ")" << std::endl
+            << "  --arc-fraction F    fraction of the segments of the traces that are arcs" << std::endl
+            << "                      (default " << defaults.arc_fraction << ")" << std::endl
+            << "  --copies XxY        copies of the board made with step and repeat" << std::endl
+            << "                      (default 1x1)" << std::endl
+            << "  --holes N           holes in each copy (default " << defaults.holes << ")" << std::endl
+            << "  --seed N            seed for the random numbers (default " << defaults.seed << ")" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+  synthetic_board::Parameters parameters;
+  string directory;
+  for (int i = 1; i < argc; i++) {
+    const string arg = argv[i];
+    const bool has_value = i + 1 < argc;
+    if (arg == "--traces" && has_value) {
+      parameters.traces = std::strtoul(argv[++i], nullptr, 10);
+    } else if (arg == "--pad-density" && has_value) {
+      parameters.pad_density = std::strtod(argv[++i], nullptr);
+    } else if (arg == "--pour-fraction" && has_value) {
+      parameters.pour_fraction = std::strtod(argv[++i], nullptr);
+    } else if (arg == "--arc-fraction" && has_value) {
+      parameters.arc_fraction = std::strtod(argv[++i], nullptr);
+    } else if (arg == "--copies" && has_value) {
+      char* end;
+      parameters.copies_x = std::strtoul(argv[++i], &end, 10);
+      parameters.copies_y = *end == 'x' ? std::strtoul(end + 1, nullptr, 10) : 0;
+    } else if (arg == "--holes" && has_value) {
+      parameters.holes = std::strtoul(argv[++i], nullptr, 10);
+    } else if (arg == "--seed" && has_value) {
+      parameters.seed = std::strtoul(argv[++i], nullptr, 10);
+    } else if (arg == "--help" || arg == "-h") {
+      usage();
+      return 0;
+    } else if (directory.empty() && !arg.empty() && arg[0] != '-') {
+      directory = arg;
+    } else {
+      usage();
+      return 1;
+    }
+  }
+  if (directory.empty()) {
+    usage();
+    return 1;
+  }
+
+  try {
+    const auto summary = synthetic_board::write(directory, parameters);
+    std::cout << "Each copy has " << summary.pads << " pads, " << summary.segments << " segments of traces ("
+              << summary.arcs << " arcs), " << summary.pours << " pours and " << summary.holes
+              << " holes." << std::endl;
+  } catch (const std::exception& e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
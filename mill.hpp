@@ -62,6 +62,7 @@ class RoutingMill: public Mill {
   double backtrack;
   double stepsize;
   double offset;  // Stay away from the traces by this amount.
+  double arc_tolerance;  // Output arcs that are within this of the path, 0 for none.
 };
 
 /******************************************************************************/
@@ -77,6 +78,10 @@ class Isolator: public RoutingMill {
   bool voronoi;
   bool preserve_thermal_reliefs;
   double isolation_width;
+  bool layer_offsets;  // Offset the whole layer at once instead of each trace.
+  double draft_resolution;  // Offset a raster with cells of this size, 0 for exact.
+  unsigned int voronoi_tiles;  // Build the voronoi regions in this many strips, in parallel.
+  bool simplify_voronoi;  // Simplify the traces by the tolerance before building the voronoi regions.
 };
 
 /******************************************************************************/
@@ -54,6 +54,7 @@ using std::dynamic_pointer_cast;
 using boost::format;
 
 #include "units.hpp"
+#include "arc_fitting.hpp"
 
 NGC_Exporter::NGC_Exporter(shared_ptr<Board> board)
     : board(board), ocodes(1), globalVars(100) {}
@@ -156,6 +157,11 @@ void NGC_Exporter::cutter_milling(std::ofstream& of, shared_ptr<Cutter> cutter,
     of << "G04 P0 ( dwell for no time -- G64 should not smooth over this point )\n";
     of << "G01 F" << cutter->feed * cfactor << "\n";
 
+    if (bridges.empty() && cutter->arc_tolerance > 0) {
+      arc_milling(of, path, cutter->arc_tolerance, xoffsetTot, yoffsetTot);
+      continue;
+    }
+
     auto current_bridge = bridges.cbegin();
 
     bool in_bridge = false;
@@ -185,6 +191,26 @@ void NGC_Exporter::cutter_milling(std::ofstream& of, shared_ptr<Cutter> cutter,
   }
 }
 
+/* Cut along the path from its first point, which is where the tool is now,
+ * replacing runs of segments that fit an arc with G02/G03. */
+void NGC_Exporter::arc_milling(std::ofstream& of, const linestring_type_fp& path, const double arc_tolerance,
+                               const double xoffsetTot, const double yoffsetTot) {
+  point_type_fp current = path.front();
+  for (const auto& move : arc_fitting::fit_arcs(path, arc_tolerance)) {
+    if (move.center) {
+      of << (move.clockwise ? "G02" : "G03")
+         << " X" << (move.end.x() - xoffsetTot) * cfactor
+         << " Y" << (move.end.y() - yoffsetTot) * cfactor
+         << " I" << (move.center->x() - current.x()) * cfactor
+         << " J" << (move.center->y() - current.y()) * cfactor << '\n';
+    } else {
+      of << "G01 X" << (move.end.x() - xoffsetTot) * cfactor
+         << " Y"    << (move.end.y() - yoffsetTot) * cfactor << '\n';
+    }
+    current = move.end;
+  }
+}
+
 void NGC_Exporter::isolation_milling(std::ofstream& of, shared_ptr<RoutingMill> mill, const linestring_type_fp& path,
                                      boost::optional<autoleveller>& leveller, const double xoffsetTot, const double yoffsetTot) {
   of << "G01 F" << mill->vertfeed * cfactor << '\n';
@@ -223,6 +249,14 @@ void NGC_Exporter::isolation_milling(std::ofstream& of, shared_ptr<RoutingMill>
     }
     of << "G04 P0 ( dwell for no time -- G64 should not smooth over this point )\n";
     of << "G01 F" << mill->feed * cfactor << '\n';
+    if (!leveller && mill->arc_tolerance > 0) {
+      // The autoleveller needs to correct every point so there are no arcs
+      // with it.
+      of << "G01 X" << (path.front().x() - xoffsetTot) * cfactor << " Y"
+         << (path.front().y() - yoffsetTot) * cfactor << '\n';
+      arc_milling(of, path, mill->arc_tolerance, xoffsetTot, yoffsetTot);
+      continue;
+    }
     while (iter != path.cend()) {
       if (leveller) {
         of << leveller->addChainPoint(point_type_fp((iter->x() - xoffsetTot) * cfactor,
@@ -288,8 +322,11 @@ void NGC_Exporter::export_layer(shared_ptr<Layer> layer, string of_name, boost::
          << "G20 ( Units == INCHES. )\n\n";
     }
 
-    of << "G90 ( Absolute coordinates. )\n"
-       << "G00 S" << left << mill->speed << " ( RPM spindle speed. )\n";
+    of << "G90 ( Absolute coordinates. )\n";
+    if (mill->arc_tolerance > 0) {
+      of << "G91.1 ( Arc centers are relative to the start of each arc. )\n";
+    }
+    of << "G00 S" << left << mill->speed << " ( RPM spindle speed. )\n";
 
     if (mill->explicit_tolerance) {
       of << "G64 P" << mill->tolerance * cfactor << " ( set maximum deviation from commanded toolpath )\n";
@@ -55,6 +55,8 @@ protected:
                       const std::vector<size_t>& bridges, const double xoffsetTot, const double yoffsetTot);
   void isolation_milling(std::ofstream& of, std::shared_ptr<RoutingMill> mill, const linestring_type_fp& path,
                          boost::optional<autoleveller>& leveller, const double xoffsetTot, const double yoffsetTot);
+  void arc_milling(std::ofstream& of, const linestring_type_fp& path, const double arc_tolerance,
+                   const double xoffsetTot, const double yoffsetTot);
 
     std::shared_ptr<Board> board;
     std::vector<std::string> header;
@@ -295,7 +295,23 @@ options::options()
        ("path-finding-limit", po::value<size_t>()->default_value(1), "Use path finding for up to this many steps in the search (more is slower but makes a faster gcode path)")
        ("g0-vertical-speed", po::value<Velocity>()->default_value(parse_unit<Velocity>("50in/min")), "speed of vertical G0 movements, for use in path-finding")
        ("g0-horizontal-speed", po::value<Velocity>()->default_value(parse_unit<Velocity>("100in/min")), "speed of horizontal G0 movements, for use in path-finding")
-       ("backtrack", po::value<Velocity>()->default_value(std::numeric_limits<double>::infinity()), "allow retracing a milled path if it's faster than retract-move-lower.  For example, set to 5in/s if you are willing to remill 5 inches of trace in order to save 1 second of milling time.");
+       ("backtrack", po::value<Velocity>()->default_value(std::numeric_limits<double>::infinity()), "allow retracing a milled path if it's faster than retract-move-lower.  For example, set to 5in/s if you are willing to remill 5 inches of trace in order to save 1 second of milling time.")
+       ("arc-tolerance", po::value<Length>()->default_value(Length(0)),
+        "Output G02/G03 arcs in place of runs of short segments that are all within this distance of an arc.  This makes smaller and smoother gcode.  The arc centers are given relative to the start of each arc and G91.1 is output to select that.  Not used with the autoleveller.  Set to 0 to disable (default).")
+       ("adaptive-circles", po::value<bool>()->default_value(false)->implicit_value(true),
+        "Use only as many points for circles, arcs and round corners as are needed to stay within the tolerance.  Large circles get far fewer points, which makes processing faster.  Disabled by default.")
+       ("layer-offsets", po::value<bool>()->default_value(false)->implicit_value(true),
+        "Offset the whole layer once for each isolation pass instead of each trace separately, and cut each trace's passes and keep-out areas from that.  Faster for boards with many traces but the output may differ very slightly.  Not used for voronoi milling.  Disabled by default.")
+       ("draft-resolution", po::value<Length>()->default_value(Length(0)),
+        "Make the isolation passes from a raster of the layer with cells of this size instead of from exact offsets.  Much faster for large boards but only accurate to about the cell size, for checking placement and job time.  Set to 0 to disable (default).")
+       ("voronoi-tiles", po::value<unsigned int>()->default_value(1),
+        "Build the voronoi regions in this many vertical strips of the board, in parallel.  The regions are unchanged where the isolation passes are but, far from all traces, the strips might not line up, so this can't be used with --voronoi.  Fewer strips are used if they would be narrower than the isolation width.  Set to 1 to build them all at once (default).")
+       ("simplify-voronoi", po::value<bool>()->default_value(false)->implicit_value(true),
+        "Simplify the traces by the tolerance before building the voronoi regions, which is faster for boards with many round pads.  Traces closer than twice the tolerance to another are kept as they are so that each trace stays inside its region.  Disabled by default.")
+       ("cache-dir", po::value<string>()->default_value(""),
+        "Keep the rendered layers, voronoi regions and toolpaths in this directory and reuse them when run again on the same input files.  Changing only options for the gcode output, such as the spindle speed, tiling, software or preamble, then skips making the toolpaths, along with their debugging images.  Empty to disable (default).")
+       ("cache-size", po::value<unsigned int>()->default_value(1024),
+        "The most megabytes to keep in --cache-dir.  After each run, the files that were used least recently are removed until the rest fit.  0 for no limit.  Defaults to 1024.");
    cfg_options.add(optimization_options);
 
    po::options_description autolevelling_options("Autolevelling options, for generating gcode to automatically probe the board and adjust milling depth to the actual board height");
@@ -352,7 +368,12 @@ options::options()
        ("preamble-text", po::value<string>(), "preamble text file, inserted at the very beginning as a comment.")
        ("preamble", po::value<string>(), "gcode preamble file, inserted at the very beginning.")
        ("postamble", po::value<string>(), "gcode postamble file, inserted before M9 and M2.")
-       ("no-export", po::value<bool>()->default_value(false)->implicit_value(true), "skip the exporting process");
+       ("no-export", po::value<bool>()->default_value(false)->implicit_value(true), "skip the exporting process")
+       ("report-stats", po::value<bool>()->default_value(false)->implicit_value(true), "print the number of vertices and the time taken at each stage of processing")
+       ("debug-output", po::value<DebugOutput::DebugOutput>()->default_value(DebugOutput::FULL, "full"),
+        "which debugging SVG files to write: none, contentions (only where the clearance can't be kept) or full")
+       ("record-stage", po::value<RecordStage::RecordStage>()->default_value(RecordStage::NONE, "none"),
+        "save the inputs of a stage of making the toolpaths each time that it runs, in a new directory in the output directory, so that it can be timed alone with replay_stage: single-toolpath, path-finding, post-process, tsp or none.  Stages loaded from --cache-dir aren't run so they aren't recorded");
 }
 
 /******************************************************************************/
@@ -412,6 +433,20 @@ static void check_generic_parameters(po::variables_map const& vm)
         }
     }
 
+    //---------------------------------------------------------------------------
+    //Check arc-tolerance parameter:
+
+    if (vm["arc-tolerance"].as<Length>().asInch(unit) < 0) {
+      options::maybe_throw("arc-tolerance can't be negative!", ERR_NEGATIVEARCTOLERANCE);
+    }
+
+    //---------------------------------------------------------------------------
+    //Check draft-resolution parameter:
+
+    if (vm["draft-resolution"].as<Length>().asInch(unit) < 0) {
+      options::maybe_throw("draft-resolution can't be negative!", ERR_NEGATIVEDRAFTRESOLUTION);
+    }
+
     //---------------------------------------------------------------------------
     //Check svg parameter:
 
@@ -484,6 +519,9 @@ static void check_generic_parameters(po::variables_map const& vm)
         vm["tsp-2opt"].as<bool>()) {
       options::maybe_throw("Error: Can't use tsp-2opt together with mill-feed-direction", ERR_INVALIDPARAMETER);
     }
+    if (vm["voronoi"].as<bool>() && vm["voronoi-tiles"].as<unsigned int>() > 1) {
+      options::maybe_throw("Error: Can't use voronoi-tiles together with voronoi", ERR_INVALIDPARAMETER);
+    }
 }
 
 /******************************************************************************/
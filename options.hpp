@@ -88,6 +88,8 @@ enum ErrorCodes {
     ERR_NEGATIVESPINDOWN = 53,
     ERR_FALSEMIRRORABSOLUTE = 54,
     ERR_LOWMILLINFEED = 55,
+    ERR_NEGATIVEARCTOLERANCE = 56,
+    ERR_NEGATIVEDRAFTRESOLUTION = 57,
     ERR_INVALIDPARAMETER = 100,
     ERR_UNKNOWNPARAMETER = 101
 };
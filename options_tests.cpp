@@ -91,4 +91,9 @@ BOOST_AUTO_TEST_CASE(milling_overlap) {
       pcb2gcode_parse_exception);
 }
 
+BOOST_AUTO_TEST_CASE(voronoi_tiles) {
+  BOOST_CHECK_EQUAL(get_value<unsigned int>("pcb2gcode", "voronoi-tiles"), 1U);
+  BOOST_CHECK_EQUAL(get_value<unsigned int>("pcb2gcode --voronoi-tiles 8", "voronoi-tiles"), 8U);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,38 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace parallel {
+
+// As many threads as the hardware supports, at least one.
+inline unsigned int hardware_threads() {
+  return std::max(1U, std::thread::hardware_concurrency());
+}
+
+// Call f(begin, end) on ranges that together cover [0, count), each in its
+// own thread.  With one thread or less, f is called on the whole range in the
+// calling thread.
+template <typename F>
+void for_ranges(size_t count, unsigned int threads, F f) {
+  threads = std::min(size_t(threads), count);
+  if (threads <= 1) {
+    f(0, count);
+    return;
+  }
+  std::vector<std::thread> workers;
+  workers.reserve(threads);
+  for (size_t i = 0; i < threads; i++) {
+    workers.emplace_back(f, count * i / threads, count * (i + 1) / threads);
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+} // namespace parallel
+
+#endif // PARALLEL_HPP
@@ -144,7 +144,13 @@ vector<vector<std::reference_wrapper<const ring_type_fp>>> get_all_rings(
 
 PathFindingSurface::PathFindingSurface(const optional<multi_polygon_type_fp>& keep_in,
                                        const multi_polygon_type_fp& keep_out,
-                                       const coordinate_type_fp tolerance) {
+                                       const coordinate_type_fp tolerance,
+                                       bool keep_inputs) :
+    kept_inputs_(keep_inputs), tolerance_(tolerance) {
+  if (keep_inputs) {
+    keep_in_ = keep_in;
+    keep_out_ = keep_out;
+  }
   if (keep_in) {
     multi_polygon_type_fp total_keep_in = *keep_in - keep_out;
 
@@ -176,10 +176,12 @@ class PathFindingSurface {
   // Create a surface for doing path finding.  It can be used multiple times.  The
   // surface available for paths is within the keep_in and also outside the
   // keep_out.  If those are missing, they are ignored.  The tolerance should be a
-  // small epsilon value.
+  // small epsilon value.  The keep_in and keep_out are copied only if
+  // keep_inputs is true, for recording the surface.
   PathFindingSurface(const boost::optional<multi_polygon_type_fp>& keep_in,
                      const multi_polygon_type_fp& keep_out,
-                     const coordinate_type_fp tolerance);
+                     const coordinate_type_fp tolerance,
+                     bool keep_inputs = false);
   const boost::optional<SearchKey>& in_surface(point_type_fp p) const;
   void decrement_tries() const;
   Neighbors neighbors(const point_type_fp& start, const point_type_fp& goal,
@@ -201,6 +203,11 @@ class PathFindingSurface {
       SearchKey search_key) const;
   const std::vector<point_type_fp>& vertices(SearchKey search_key) const;
   multi_polygon_type_fp get_surface() const;
+  // What the surface was made from, if keep_inputs was true.
+  bool kept_inputs() const { return kept_inputs_; }
+  const boost::optional<multi_polygon_type_fp>& keep_in() const { return keep_in_; }
+  const multi_polygon_type_fp& keep_out() const { return keep_out_; }
+  coordinate_type_fp tolerance() const { return tolerance_; }
 
  private:
   friend class Neighbors;
@@ -211,6 +218,10 @@ class PathFindingSurface {
       const coordinate_type_fp& max_path_length,
       SearchKey search_key) const;
 
+  bool kept_inputs_;
+  boost::optional<multi_polygon_type_fp> keep_in_;
+  multi_polygon_type_fp keep_out_;
+  coordinate_type_fp tolerance_;
   // Each shape corresponses to an element in all_vertices and they
   // are in the same order.  The boolean indicates if this is the
   // outer.  This is later used for computing the inside/outside of
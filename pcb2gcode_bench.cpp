@@ -0,0 +1,717 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <regex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+using std::pair;
+using std::string;
+using std::vector;
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include <boost/optional.hpp>
+
+#include "geometry.hpp"
+#include "backtrack.hpp"
+#include "bg_helpers.hpp"
+#include "bg_operators.hpp"
+#include "common.hpp"
+#include "eulerian_paths.hpp"
+#include "gerberimporter.hpp"
+#include "path_finding.hpp"
+#include "segment_tree.hpp"
+#include "segmentize.hpp"
+#include "synthetic_board.hpp"
+#include "tsp_solver.hpp"
+#include "voronoi.hpp"
+
+// Benchmarks of the parts of pcb2gcode that take the most time, on inputs of a
+// few sizes, and of the whole of pcb2gcode on the example boards and on
+// synthetic boards of any size.  Each benchmark is run until a sample takes
+// long enough to time well, then that many times again for each sample.  The
+// median and the median absolute deviation of the samples are reported
+// because they aren't thrown off by the odd slow sample.
+
+struct Options {
+  std::regex filter{""};
+  bool filtered = false;
+  unsigned int samples = 10;
+  unsigned int end_to_end_samples = 3;
+  double min_sample_time = 0.05;
+  string json;
+  string pcb2gcode = "./pcb2gcode";
+  string examples = "testing/gerbv_example";
+  vector<string> boards;
+  // The number of traces on each synthetic board.
+  vector<size_t> synthetic;
+  bool end_to_end = true;
+  bool list = false;
+};
+
+// The boards from the examples that are used unless others are requested.
+// They are the largest ones and between them they use most of the features.
+static const vector<string> DEFAULT_BOARDS = {
+  "D1MiniGSR",
+  "Easy-SDR_HF_Upconverter_SMD_Gerbers",
+  "KNoT-Gateway Mini Starter Board",
+  "KeyboardControllerM102",
+  "am-test-voronoi",
+  "multivibrator",
+  "multivibrator-extra-passes-big",
+  "multivibrator-extra-passes-voronoi",
+  "project-controller",
+};
+
+// A directory with a millproject and the files that it names.
+struct Board {
+  string name;
+  string directory;
+};
+
+struct Result {
+  string name;
+  size_t iterations;
+  // Seconds per iteration of each sample, sorted.
+  vector<double> seconds;
+  // The most memory used by pcb2gcode in any sample, if it was run.
+  long peak_memory_kb;
+
+  double median() const {
+    return median_of(seconds);
+  }
+  double median_absolute_deviation() const {
+    vector<double> deviations;
+    const double m = median();
+    for (const auto& s : seconds) {
+      deviations.push_back(std::abs(s - m));
+    }
+    std::sort(deviations.begin(), deviations.end());
+    return median_of(deviations);
+  }
+
+ private:
+  static double median_of(const vector<double>& sorted) {
+    const size_t middle = sorted.size() / 2;
+    return sorted.size() % 2 ? sorted[middle] : (sorted[middle - 1] + sorted[middle]) / 2;
+  }
+};
+
+// Keeps the results of the benchmarks so that they aren't optimized away.
+static volatile size_t sink;
+
+class Runner {
+ public:
+  explicit Runner(const Options& options) : options(options) {}
+
+  bool selected(const string& name) const {
+    return !options.filtered || std::regex_search(name, options.filter);
+  }
+
+  // setup() makes the state for one iteration of body(state), which returns
+  // a count of what it made.  Only body is timed.
+  template <typename Setup, typename Body>
+  void run(const string& name, unsigned int samples, Setup setup, Body body) {
+    if (!selected(name)) {
+      return;
+    }
+    if (options.list) {
+      std::cout << name << std::endl;
+      return;
+    }
+    // The first run warms up the caches and the second shows how many
+    // iterations are needed for a sample.
+    time(1, setup, body);
+    const double once = time(1, setup, body);
+    const size_t iterations = once >= options.min_sample_time ? 1 :
+        std::min<size_t>(std::ceil(options.min_sample_time / std::max(once, 1e-9)), 1000000);
+    peak_memory_kb = 0;
+    Result result{name, iterations, {}, 0};
+    for (unsigned int sample = 0; sample < samples; sample++) {
+      result.seconds.push_back(time(iterations, setup, body) / iterations);
+    }
+    std::sort(result.seconds.begin(), result.seconds.end());
+    result.peak_memory_kb = peak_memory_kb;
+    print(result);
+    results_.push_back(std::move(result));
+  }
+
+  template <typename Body>
+  void run(const string& name, Body body) {
+    run(name, options.samples, []() { return 0; }, [&](int) { return body(); });
+  }
+
+  const vector<Result>& results() const {
+    return results_;
+  }
+
+  // For benchmarks that run pcb2gcode, the memory that it used.
+  void note_peak_memory(long kilobytes) {
+    peak_memory_kb = std::max(peak_memory_kb, kilobytes);
+  }
+
+ private:
+  template <typename Setup, typename Body>
+  static double time(size_t iterations, Setup& setup, Body& body) {
+    std::chrono::steady_clock::duration elapsed{0};
+    for (size_t i = 0; i < iterations; i++) {
+      auto state = setup();
+      const auto start = std::chrono::steady_clock::now();
+      sink += body(state);
+      elapsed += std::chrono::steady_clock::now() - start;
+    }
+    return std::chrono::duration<double>(elapsed).count();
+  }
+
+  static string format_time(double seconds) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3);
+    if (seconds >= 1) {
+      out << seconds << "s";
+    } else if (seconds >= 1e-3) {
+      out << seconds * 1e3 << "ms";
+    } else {
+      out << seconds * 1e6 << "us";
+    }
+    return out.str();
+  }
+
+  static void print(const Result& result) {
+    const double median = result.median();
+    std::cout << std::left << std::setw(64) << result.name << std::right
+              << std::setw(12) << format_time(median)
+              << " +-" << std::fixed << std::setprecision(1) << std::setw(5)
+              << (median > 0 ? 100 * result.median_absolute_deviation() / median : 0) << "%"
+              << "  min " << std::setw(12) << format_time(result.seconds.front())
+              << "  x" << result.iterations;
+    if (result.peak_memory_kb > 0) {
+      std::cout << "  peak " << std::setprecision(1) << result.peak_memory_kb / 1024.0 << "MB";
+    }
+    std::cout << std::endl;
+  }
+
+  const Options& options;
+  vector<Result> results_;
+  long peak_memory_kb = 0;
+};
+
+static string json_string(const string& s) {
+  string out = "\"";
+  for (const char c : s) {
+    if (c == '"' || c == '\\') {
+      out += '\\';
+    }
+    out += c;
+  }
+  return out + "\"";
+}
+
+// Times are in seconds per iteration and memory is in kilobytes.
+static void write_json(const string& filename, const vector<Result>& results) {
+  std::ofstream out(filename);
+  out << std::setprecision(9);
+  out << "{\n  \"version\": " << json_string(GIT_VERSION) << ",\n  \"benchmarks\": [";
+  for (size_t i = 0; i < results.size(); i++) {
+    const Result& result = results[i];
+    out << (i ? "," : "") << "\n    {\"name\": " << json_string(result.name)
+        << ", \"iterations\": " << result.iterations
+        << ", \"samples\": " << result.seconds.size()
+        << ", \"median\": " << result.median()
+        << ", \"mad\": " << result.median_absolute_deviation()
+        << ", \"min\": " << result.seconds.front()
+        << ", \"max\": " << result.seconds.back();
+    if (result.peak_memory_kb > 0) {
+      out << ", \"peak_memory_kb\": " << result.peak_memory_kb;
+    }
+    out << "}";
+  }
+  out << "\n  ]\n}\n";
+  out.close();
+  if (!out) {
+    throw std::runtime_error("Can't write " + filename);
+  }
+}
+
+// The same inputs every time.
+static std::mt19937 random_generator() {
+  return std::mt19937(1);
+}
+
+static multi_polygon_type_fp pad(const point_type_fp& center) {
+  return bg_helpers::buffer(multi_linestring_type_fp{linestring_type_fp{
+        center, point_type_fp(center.x() + 0.001, center.y())}}, 0.02);
+}
+
+// An n by n grid of round pads 0.1 inches apart with traces between half of
+// the neighbours, as separate shapes.
+static vector<multi_polygon_type_fp> board_shapes(unsigned int n) {
+  auto generator = random_generator();
+  std::bernoulli_distribution trace(0.5);
+  vector<multi_polygon_type_fp> shapes;
+  for (unsigned int x = 0; x < n; x++) {
+    for (unsigned int y = 0; y < n; y++) {
+      const double cx = x * 0.1;
+      const double cy = y * 0.1;
+      shapes.push_back(pad(point_type_fp(cx, cy)));
+      if (x + 1 < n && trace(generator)) {
+        const linestring_type_fp ls{{cx, cy}, {cx + 0.05, cy + 0.03}, {cx + 0.1, cy}};
+        shapes.push_back(bg_helpers::buffer(multi_linestring_type_fp{ls}, 0.006));
+      }
+    }
+  }
+  return shapes;
+}
+
+static multi_polygon_type_fp board(unsigned int n) {
+  return sum(board_shapes(n));
+}
+
+// The point in the middle of the gap between four pads, which is never on a
+// trace.
+static point_type_fp gap(unsigned int x, unsigned int y) {
+  return point_type_fp(x * 0.1 + 0.05, y * 0.1 + 0.05);
+}
+
+// Every ring of the board as a path that may be reversed, like the toolpath
+// around each trace.
+static vector<pair<linestring_type_fp, bool>> outlines(const multi_polygon_type_fp& mp) {
+  vector<pair<linestring_type_fp, bool>> paths;
+  const auto add = [&](const ring_type_fp& ring) {
+    paths.emplace_back(linestring_type_fp(ring.cbegin(), ring.cend()), true);
+  };
+  for (const auto& poly : mp) {
+    add(poly.outer());
+    for (const auto& inner : poly.inners()) {
+      add(inner);
+    }
+  }
+  return paths;
+}
+
+// Short segments all over the unit square.
+static vector<pair<point_type_fp, point_type_fp>> random_segments(size_t count) {
+  auto generator = random_generator();
+  std::uniform_real_distribution<double> position(0, 1);
+  std::uniform_real_distribution<double> offset(-0.02, 0.02);
+  vector<pair<point_type_fp, point_type_fp>> segments;
+  for (size_t i = 0; i < count; i++) {
+    const point_type_fp start(position(generator), position(generator));
+    segments.emplace_back(start, point_type_fp(start.x() + offset(generator),
+                                               start.y() + offset(generator)));
+  }
+  return segments;
+}
+
+static void segment_tree_benchmarks(Runner& runner) {
+  for (const size_t count : {100, 1000, 10000}) {
+    const auto segments = random_segments(count);
+    runner.run("segment_tree/build/" + std::to_string(count), [&]() {
+      const segment_tree::SegmentTree tree(segments);
+      return segments.size();
+    });
+    const segment_tree::SegmentTree tree(segments);
+    const auto queries = random_segments(1000);
+    runner.run("segment_tree/intersects_1000/" + std::to_string(count), [&]() {
+      size_t found = 0;
+      for (const auto& query : queries) {
+        found += tree.intersects(query.first, query.second);
+      }
+      return found;
+    });
+  }
+}
+
+static void path_finding_benchmarks(Runner& runner, unsigned int samples) {
+  for (const unsigned int n : {4, 8, 16}) {
+    const auto keep_out = board(n);
+    const string size = std::to_string(n) + "x" + std::to_string(n);
+    runner.run("path_finding/surface/" + size, [&]() {
+      const path_finding::PathFindingSurface surface(boost::none, keep_out, 0.0001);
+      return keep_out.size();
+    });
+    // Between gaps picked at random on opposite sides of the board.
+    auto generator = random_generator();
+    std::uniform_int_distribution<unsigned int> gap_index(0, n - 2);
+    vector<pair<point_type_fp, point_type_fp>> ends;
+    for (unsigned int i = 0; i < 20; i++) {
+      ends.emplace_back(gap(0, gap_index(generator)), gap(n - 2, gap_index(generator)));
+    }
+    for (const size_t tries : {1, 1000}) {
+      // The surface remembers what it found so each iteration needs a new one.
+      runner.run("path_finding/find_path_20/" + size + "/tries_" + std::to_string(tries), samples,
+                 [&]() {
+                   return std::make_shared<path_finding::PathFindingSurface>(
+                       boost::none, keep_out, 0.0001);
+                 },
+                 [&](const std::shared_ptr<path_finding::PathFindingSurface>& surface) {
+                   size_t points = 0;
+                   for (const auto& end : ends) {
+                     const auto path = surface->find_path(end.first, end.second,
+                                                          std::numeric_limits<double>::infinity(),
+                                                          boost::make_optional(tries));
+                     points += path ? path->size() : 0;
+                   }
+                   return points;
+                 });
+    }
+  }
+}
+
+static void tsp_solver_benchmarks(Runner& runner, unsigned int samples) {
+  for (const size_t count : {100, 1000, 5000}) {
+    multi_linestring_type_fp paths;
+    for (const auto& segment : random_segments(count)) {
+      paths.push_back(linestring_type_fp{segment.first, segment.second});
+    }
+    const auto copy = [&]() { return paths; };
+    runner.run("tsp_solver/nearest_neighbour/" + std::to_string(count), samples, copy,
+               [](multi_linestring_type_fp& path) {
+                 tsp_solver::nearest_neighbour(path, point_type_fp(0, 0));
+                 return path.size();
+               });
+    if (count > 1000) {
+      continue;  // Too slow.
+    }
+    runner.run("tsp_solver/tsp_2opt/" + std::to_string(count), samples, copy,
+               [](multi_linestring_type_fp& path) {
+                 tsp_solver::tsp_2opt(path, point_type_fp(0, 0));
+                 return path.size();
+               });
+  }
+}
+
+// The steps that turn the toolpaths around the traces into as few paths as
+// possible.
+static void toolpath_benchmarks(Runner& runner) {
+  for (const unsigned int n : {4, 8, 16}) {
+    const string size = std::to_string(n) + "x" + std::to_string(n);
+    const auto paths = outlines(board(n));
+    runner.run("segmentize/segmentize_paths/" + size, [&]() {
+      return segmentize::segmentize_paths(paths).size();
+    });
+    const auto segments = segmentize::unique(segmentize::segmentize_paths(paths));
+    runner.run("backtrack/" + size, [&]() {
+      return backtrack::backtrack(segments, 10, 0.1, 50, 0.2,
+                                  std::numeric_limits<double>::infinity()).size();
+    });
+    runner.run("eulerian_paths/get_eulerian_paths/" + size, [&]() {
+      return eulerian_paths::get_eulerian_paths<point_type_fp, linestring_type_fp>(segments).size();
+    });
+  }
+}
+
+static void geometry_benchmarks(Runner& runner) {
+  for (const unsigned int n : {4, 8, 16, 32}) {
+    const string size = std::to_string(n) + "x" + std::to_string(n);
+    const auto shapes = board_shapes(n);
+    runner.run("bg_operators/sum/" + size, [&]() {
+      return sum(shapes).size();
+    });
+    const auto traces = sum(shapes);
+    // Uncached, or every iteration after the first would be a cache hit.
+    bg_helpers::enable_cache(false);
+    runner.run("bg_helpers/buffer/" + size, [&]() {
+      return bg_helpers::buffer(traces, 0.005).size();
+    });
+    bg_helpers::enable_cache(true);
+    auto bounding_box = bg::return_envelope<box_type_fp>(traces);
+    bg::buffer(bounding_box, bounding_box, 0.1);
+    if (n > 8) {
+      continue;  // Too slow.
+    }
+    for (const unsigned int tiles : {1, 4}) {
+      runner.run("voronoi/build_voronoi/" + size + "/tiles_" + std::to_string(tiles), [&]() {
+        return Voronoi::build_voronoi(traces, bounding_box, 0.0004, tiles).size();
+      });
+    }
+  }
+}
+
+// The settings in the millproject file of an example.
+static vector<pair<string, string>> read_millproject(const string& directory) {
+  vector<pair<string, string>> settings;
+  std::ifstream in(build_filename(directory, "millproject"));
+  string line;
+  while (std::getline(in, line)) {
+    const auto equals = line.find('=');
+    if (equals != string::npos) {
+      settings.emplace_back(line.substr(0, equals), line.substr(equals + 1));
+    }
+  }
+  return settings;
+}
+
+static void board_benchmarks(Runner& runner, const vector<Board>& boards) {
+  for (const auto& board : boards) {
+    for (const auto& setting : read_millproject(board.directory)) {
+      if (setting.first != "front" && setting.first != "back" && setting.first != "outline") {
+        continue;
+      }
+      const string name = "gerber_importer/render/" + board.name + "/" + setting.first;
+      // The outline is filled like pcb2gcode does and has no voronoi regions.
+      const bool fill = setting.first == "outline";
+      const string voronoi_name = "voronoi/build_voronoi/" + board.name + "/" + setting.first;
+      const bool voronoi = !fill && (runner.selected(voronoi_name + "/32_bit") ||
+                                     runner.selected(voronoi_name + "/64_bit"));
+      if (!runner.selected(name) && !voronoi) {
+        continue;
+      }
+      GerberImporter importer(0.0004);
+      if (!importer.load_file(build_filename(board.directory, setting.second))) {
+        std::cerr << "Skipping " << name << ", " << setting.second << " can't be loaded." << std::endl;
+        continue;
+      }
+      // Rendering buffers the draws, which would be cached after the first
+      // iteration.
+      bg_helpers::enable_cache(false);
+      runner.run(name, [&]() {
+        return importer.render(fill, false).first.size();
+      });
+      bg_helpers::enable_cache(true);
+      if (!voronoi) {
+        continue;
+      }
+      // The same traces far enough out that the coordinates don't fit in 32
+      // bits, so that the two voronoi builders can be compared on real boards.
+      const auto traces = importer.render(fill, false).first;
+      auto bounding_box = bg::return_envelope<box_type_fp>(traces);
+      bg::buffer(bounding_box, bounding_box, 0.1);
+      const double shift = 10000;
+      const bg::strategy::transform::translate_transformer<coordinate_type_fp, 2, 2> translate(shift, shift);
+      multi_polygon_type_fp shifted_traces;
+      bg::transform(traces, shifted_traces, translate);
+      box_type_fp shifted_bounding_box;
+      bg::transform(bounding_box, shifted_bounding_box, translate);
+      runner.run(voronoi_name + "/32_bit", [&]() {
+        return Voronoi::build_voronoi(traces, bounding_box, 0.0004).size();
+      });
+      runner.run(voronoi_name + "/64_bit", [&]() {
+        return Voronoi::build_voronoi(shifted_traces, shifted_bounding_box, 0.0004).size();
+      });
+    }
+  }
+}
+
+#ifndef _WIN32
+static string absolute_path(const string& path) {
+  if (!path.empty() && path[0] == '/') {
+    return path;
+  }
+  char* cwd = getcwd(nullptr, 0);
+  const string absolute = build_filename(cwd, path);
+  free(cwd);
+  return absolute;
+}
+
+static string make_temporary_directory() {
+  char name[] = "/tmp/pcb2gcode_bench_XXXXXX";
+  if (mkdtemp(name) == nullptr) {
+    throw std::runtime_error("Can't make a temporary directory");
+  }
+  return name;
+}
+
+static void remove_directory(const string& directory) {
+  if (DIR* dir = opendir(directory.c_str())) {
+    while (const struct dirent* entry = readdir(dir)) {
+      const string name = entry->d_name;
+      const string path = build_filename(directory, name);
+      if (name != "." && name != ".." && unlink(path.c_str()) != 0) {
+        remove_directory(path);
+      }
+    }
+    closedir(dir);
+  }
+  rmdir(directory.c_str());
+}
+
+// Synthetic boards with more and more traces, and holes and pours to match, to
+// see how the time and memory grow with the size of the board.
+static vector<Board> make_synthetic_boards(const vector<size_t>& sizes, const string& directory) {
+  vector<Board> boards;
+  for (const size_t traces : sizes) {
+    synthetic_board::Parameters parameters;
+    parameters.traces = traces;
+    parameters.holes = traces / 2;
+    parameters.pour_fraction = 0.2;
+    const string name = "synthetic_" + std::to_string(traces);
+    boards.push_back({name, build_filename(directory, name)});
+    synthetic_board::write(boards.back().directory, parameters);
+  }
+  return boards;
+}
+
+// Runs pcb2gcode on each board, like integration_tests.py does, with the
+// output in a temporary directory.
+static void end_to_end_benchmarks(Runner& runner, const Options& options, const vector<Board>& boards) {
+  const string pcb2gcode = absolute_path(options.pcb2gcode);
+  if (access(pcb2gcode.c_str(), X_OK) != 0) {
+    std::cerr << "Skipping the end to end benchmarks, " << pcb2gcode << " can't be run." << std::endl;
+    return;
+  }
+  const string output_directory = make_temporary_directory();
+  for (const auto& board : boards) {
+    runner.run("end_to_end/" + board.name, options.end_to_end_samples, []() { return 0; }, [&](int) {
+      const pid_t pid = fork();
+      if (pid == 0) {
+        const int null = open("/dev/null", O_WRONLY);
+        dup2(null, STDOUT_FILENO);
+        dup2(null, STDERR_FILENO);
+        if (chdir(board.directory.c_str()) == 0) {
+          execl(pcb2gcode.c_str(), pcb2gcode.c_str(), "--output-dir", output_directory.c_str(),
+                static_cast<char*>(nullptr));
+        }
+        _exit(127);
+      }
+      int status;
+      struct rusage usage;
+      if (pid < 0 || wait4(pid, &status, 0, &usage) != pid || !WIFEXITED(status) ||
+          WEXITSTATUS(status) != 0) {
+        remove_directory(output_directory);
+        throw std::runtime_error("pcb2gcode failed on " + board.directory);
+      }
+#ifdef __APPLE__
+      runner.note_peak_memory(usage.ru_maxrss / 1024);  // In bytes on macOS.
+#else
+      runner.note_peak_memory(usage.ru_maxrss);
+#endif
+      return size_t(1);
+    });
+  }
+  remove_directory(output_directory);
+}
+#else
+static string make_temporary_directory() {
+  throw std::runtime_error("Synthetic boards aren't supported on Windows.");
+}
+
+static void remove_directory(const string&) {}
+
+static vector<Board> make_synthetic_boards(const vector<size_t>&, const string&) {
+  return {};
+}
+
+static void end_to_end_benchmarks(Runner&, const Options&, const vector<Board>&) {
+  std::cerr << "Skipping the end to end benchmarks, they aren't supported on Windows." << std::endl;
+}
+#endif
+
+static void usage() {
+  std::cerr << "Usage: pcb2gcode_bench [OPTION]... [BOARD]..." << std::endl
+            << "Benchmarks the slowest parts of pcb2gcode and runs pcb2gcode on the example" << std::endl
+            << "BOARDs, by default the largest ones." << std::endl
+            << std::endl
+            << "  --filter REGEX           only run the benchmarks with names that match" << std::endl
+            << "  --list                   print the names of the benchmarks without running them" << std::endl
+            << "  --samples N              samples of each benchmark (default 10)" << std::endl
+            << "  --end-to-end-samples N   samples of each end to end run (default 3)" << std::endl
+            << "  --min-sample-time SECS   repeat each benchmark in a sample for at least this" << std::endl
+            << "                           long (default 0.05)" << std::endl
+            << "  --json FILE              also write the results to FILE as JSON" << std::endl
+            << "  --pcb2gcode PATH         the pcb2gcode to run end to end (default ./pcb2gcode)" << std::endl
+            << "  --examples DIRECTORY     where the boards are (default testing/gerbv_example)" << std::endl
+            << "  --synthetic N,...        also use synthetic boards with N traces on each side," << std::endl
+            << "                           see make_synthetic_board" << std::endl
+            << "  --no-end-to-end          don't run pcb2gcode" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+  Options options;
+  for (int i = 1; i < argc; i++) {
+    const string arg = argv[i];
+    const bool has_value = i + 1 < argc;
+    if (arg == "--filter" && has_value) {
+      options.filter = std::regex(argv[++i]);
+      options.filtered = true;
+    } else if (arg == "--list") {
+      options.list = true;
+    } else if (arg == "--samples" && has_value) {
+      options.samples = std::strtoul(argv[++i], nullptr, 10);
+    } else if (arg == "--end-to-end-samples" && has_value) {
+      options.end_to_end_samples = std::strtoul(argv[++i], nullptr, 10);
+    } else if (arg == "--min-sample-time" && has_value) {
+      options.min_sample_time = std::strtod(argv[++i], nullptr);
+    } else if (arg == "--json" && has_value) {
+      options.json = argv[++i];
+    } else if (arg == "--pcb2gcode" && has_value) {
+      options.pcb2gcode = argv[++i];
+    } else if (arg == "--examples" && has_value) {
+      options.examples = argv[++i];
+    } else if (arg == "--synthetic" && has_value) {
+      std::istringstream sizes(argv[++i]);
+      string size;
+      while (std::getline(sizes, size, ',')) {
+        options.synthetic.push_back(std::strtoul(size.c_str(), nullptr, 10));
+      }
+    } else if (arg == "--no-end-to-end") {
+      options.end_to_end = false;
+    } else if (arg == "--help" || arg == "-h") {
+      usage();
+      return 0;
+    } else if (!arg.empty() && arg[0] != '-') {
+      options.boards.push_back(arg);
+    } else {
+      usage();
+      return 1;
+    }
+  }
+  if (options.samples == 0 || options.end_to_end_samples == 0) {
+    usage();
+    return 1;
+  }
+  if (options.boards.empty()) {
+    options.boards = DEFAULT_BOARDS;
+  }
+
+  vector<Board> boards;
+  for (const auto& name : options.boards) {
+    boards.push_back({name, build_filename(options.examples, name)});
+  }
+  string synthetic_directory;
+  int result = 0;
+  try {
+    if (!options.synthetic.empty()) {
+      synthetic_directory = make_temporary_directory();
+      for (const auto& board : make_synthetic_boards(options.synthetic, synthetic_directory)) {
+        boards.push_back(board);
+      }
+    }
+    Runner runner(options);
+    // The memory used by pcb2gcode includes what this program was using when
+    // it started pcb2gcode, so that's done before anything else.
+    if (options.end_to_end) {
+      end_to_end_benchmarks(runner, options, boards);
+    }
+    segment_tree_benchmarks(runner);
+    path_finding_benchmarks(runner, options.samples);
+    tsp_solver_benchmarks(runner, options.samples);
+    toolpath_benchmarks(runner);
+    geometry_benchmarks(runner);
+    board_benchmarks(runner, boards);
+    if (!options.json.empty()) {
+      write_json(options.json, runner.results());
+    }
+  } catch (const std::exception& e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+    result = 1;
+  }
+  if (!synthetic_directory.empty()) {
+    remove_directory(synthetic_directory);
+  }
+  return result;
+}
@@ -0,0 +1,188 @@
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "bg_operators.hpp"
+#include "polygon_index.hpp"
+
+namespace polygon_index {
+
+using std::vector;
+using std::pair;
+
+static vector<pair<box_type_fp, size_t>> envelopes(const multi_polygon_type_fp& polygons) {
+  vector<pair<box_type_fp, size_t>> ret;
+  ret.reserve(polygons.size());
+  for (size_t i = 0; i < polygons.size(); i++) {
+    ret.emplace_back(bg::return_envelope<box_type_fp>(polygons[i]), i);
+  }
+  return ret;
+}
+
+PolygonIndex::PolygonIndex(multi_polygon_type_fp polygons) :
+    polygons_(std::move(polygons)),
+    tree(envelopes(polygons_)) {}
+
+multi_polygon_type_fp PolygonIndex::near(const box_type_fp& box) const {
+  vector<pair<box_type_fp, size_t>> found;
+  tree.query(bg::index::intersects(box), std::back_inserter(found));
+  // Keep the original order.
+  std::sort(found.begin(), found.end(),
+            [](const pair<box_type_fp, size_t>& a, const pair<box_type_fp, size_t>& b) {
+              return a.second < b.second;
+            });
+  multi_polygon_type_fp ret;
+  ret.reserve(found.size());
+  for (const auto& envelope_and_index : found) {
+    ret.push_back(polygons_[envelope_and_index.second]);
+  }
+  return ret;
+}
+
+multi_polygon_type_fp PolygonIndex::intersection(const multi_polygon_type_fp& shape) const {
+  if (shape.empty()) {
+    return {};
+  }
+  return near(bg::return_envelope<box_type_fp>(shape)) & shape;
+}
+
+static vector<segment_type_fp> all_edges(const multi_polygon_type_fp& polygons) {
+  vector<segment_type_fp> ret;
+  const auto add_ring = [&](const ring_type_fp& ring) {
+    for (size_t i = 0; i + 1 < ring.size(); i++) {
+      ret.emplace_back(ring[i], ring[i + 1]);
+    }
+  };
+  for (const auto& poly : polygons) {
+    add_ring(poly.outer());
+    for (const auto& inner : poly.inners()) {
+      add_ring(inner);
+    }
+  }
+  return ret;
+}
+
+static vector<pair<box_type_fp, size_t>> envelopes(const vector<segment_type_fp>& edges) {
+  vector<pair<box_type_fp, size_t>> ret;
+  ret.reserve(edges.size());
+  for (size_t i = 0; i < edges.size(); i++) {
+    ret.emplace_back(bg::return_envelope<box_type_fp>(edges[i]), i);
+  }
+  return ret;
+}
+
+EdgeIndex::EdgeIndex(multi_polygon_type_fp polygons) :
+    polygons_(std::move(polygons)),
+    envelope(bg::return_envelope<box_type_fp>(polygons_.polygons())),
+    edges(all_edges(polygons_.polygons())),
+    tree(envelopes(edges)) {}
+
+bool EdgeIndex::near_edge(const linestring_type_fp& path) const {
+  if (path.size() == 1) {
+    return tree.qbegin(bg::index::intersects(path.front())) != tree.qend();
+  }
+  for (size_t i = 0; i + 1 < path.size(); i++) {
+    const auto box = bg::return_envelope<box_type_fp>(segment_type_fp(path[i], path[i + 1]));
+    if (tree.qbegin(bg::index::intersects(box)) != tree.qend()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Count the edges crossed by a ray from p in the +x direction.  The edges
+// found aren't in the envelope of p so they are all entirely to the right of
+// p and only their y coordinates matter.
+bool EdgeIndex::inside(const point_type_fp& p) const {
+  if (!bg::covered_by(p, envelope)) {
+    return false;
+  }
+  const box_type_fp ray(p, point_type_fp(envelope.max_corner().x(), p.y()));
+  bool inside = false;
+  for (auto it = tree.qbegin(bg::index::intersects(ray)); it != tree.qend(); ++it) {
+    const auto& edge = edges[it->second];
+    if ((edge.first.y() > p.y()) != (edge.second.y() > p.y())) {
+      inside = !inside;
+    }
+  }
+  return inside;
+}
+
+multi_linestring_type_fp EdgeIndex::difference(const multi_linestring_type_fp& paths) const {
+  if (edges.empty()) {
+    return paths;
+  }
+  for (const auto& path : paths) {
+    if (!path.empty() && near_edge(path)) {
+      return paths - polygons_.near(bg::return_envelope<box_type_fp>(paths));
+    }
+  }
+  multi_linestring_type_fp ret;
+  for (const auto& path : paths) {
+    if (!path.empty() && !inside(path.front())) {
+      ret.push_back(path);
+    }
+  }
+  return ret;
+}
+
+// Quadrants with fewer points than this aren't split any further.
+static const size_t max_points_per_piece = 256;
+static const unsigned int max_depth = 12;
+
+PreparedMask::PreparedMask(const multi_polygon_type_fp& mask) {
+  root.box = bg::return_envelope<box_type_fp>(mask);
+  root.piece = mask;
+  if (!mask.empty()) {
+    split(root, 0);
+  }
+}
+
+void PreparedMask::split(Node& node, unsigned int depth) {
+  if (depth >= max_depth || bg::num_points(node.piece) < max_points_per_piece) {
+    return;
+  }
+  const auto& min = node.box.min_corner();
+  const auto& max = node.box.max_corner();
+  const point_type_fp middle((min.x() + max.x()) / 2, (min.y() + max.y()) / 2);
+  const box_type_fp quadrants[4] = {
+    {min, middle},
+    {{middle.x(), min.y()}, {max.x(), middle.y()}},
+    {middle, max},
+    {{min.x(), middle.y()}, {middle.x(), max.y()}},
+  };
+  for (size_t i = 0; i < 4; i++) {
+    node.children[i].reset(new Node);
+    auto& child = *node.children[i];
+    child.box = quadrants[i];
+    child.piece = node.piece & child.box;
+    split(child, depth + 1);
+  }
+}
+
+multi_polygon_type_fp PreparedMask::clip(const box_type_fp& box) const {
+  if (root.piece.empty() || bg::covered_by(root.box, box)) {
+    return root.piece;
+  }
+  const Node* node = &root;
+  while (node->children[0]) {
+    const Node* next = nullptr;
+    for (const auto& child : node->children) {
+      if (bg::covered_by(box, child->box)) {
+        next = child.get();
+        break;
+      }
+    }
+    if (next == nullptr) {
+      break;
+    }
+    node = next;
+  }
+  if (node->piece.empty() || !bg::intersects(node->box, box)) {
+    return {};
+  }
+  return node->piece & box;
+}
+
+} // namespace polygon_index
@@ -0,0 +1,79 @@
+#ifndef POLYGON_INDEX_HPP
+#define POLYGON_INDEX_HPP
+
+#include <array>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <boost/geometry/index/rtree.hpp>
+
+#include "geometry.hpp"
+
+namespace polygon_index {
+
+// A multi_polygon with an index of the envelopes of its polygons, so that the
+// parts of it near some other shape can be found without visiting all of it.
+class PolygonIndex {
+ public:
+  PolygonIndex(multi_polygon_type_fp polygons = {});
+  // The polygons whose envelopes intersect the box.
+  multi_polygon_type_fp near(const box_type_fp& box) const;
+  // The intersection of all the polygons with the shape.
+  multi_polygon_type_fp intersection(const multi_polygon_type_fp& shape) const;
+  const multi_polygon_type_fp& polygons() const { return polygons_; }
+
+ private:
+  multi_polygon_type_fp polygons_;
+  bg::index::rtree<std::pair<box_type_fp, size_t>, bg::index::rstar<16>> tree;
+};
+
+// A multi_polygon with an index of the edges of its rings.  Paths that don't
+// come near any edge are either entirely inside or entirely outside the
+// polygons, which can be found from the few edges crossed by a ray, so only
+// the paths near an edge need to be clipped.
+class EdgeIndex {
+ public:
+  EdgeIndex(multi_polygon_type_fp polygons = {});
+  // The paths minus the polygons.
+  multi_linestring_type_fp difference(const multi_linestring_type_fp& paths) const;
+  const multi_polygon_type_fp& polygons() const { return polygons_.polygons(); }
+
+ private:
+  bool near_edge(const linestring_type_fp& path) const;
+  // Only correct if p isn't in the envelope of any edge.
+  bool inside(const point_type_fp& p) const;
+  PolygonIndex polygons_;
+  box_type_fp envelope;
+  std::vector<segment_type_fp> edges;
+  bg::index::rtree<std::pair<box_type_fp, size_t>, bg::index::rstar<16>> tree;
+};
+
+// A large shape, like the outline of the board, prepared for being clipped to
+// many small boxes.  The shape is split into quadrants, each keeping only the
+// part of the shape inside it, and those are split again until the parts are
+// small.  Clipping starts from the smallest quadrant that holds the whole box
+// so the cost depends on how much of the shape is near the box and not on the
+// size of the whole shape.
+class PreparedMask {
+ public:
+  PreparedMask(const multi_polygon_type_fp& mask);
+  // The part of the mask inside the box.  If the box holds the entire mask,
+  // that's the mask unchanged.
+  multi_polygon_type_fp clip(const box_type_fp& box) const;
+  const multi_polygon_type_fp& mask() const { return root.piece; }
+  const box_type_fp& envelope() const { return root.box; }
+
+ private:
+  struct Node {
+    box_type_fp box;
+    multi_polygon_type_fp piece;
+    std::array<std::unique_ptr<Node>, 4> children;
+  };
+  static void split(Node& node, unsigned int depth);
+  Node root;
+};
+
+} // namespace polygon_index
+
+#endif // POLYGON_INDEX_HPP
@@ -0,0 +1,116 @@
+#define BOOST_TEST_MODULE polygon index tests
+#include <boost/test/unit_test.hpp>
+
+#include "geometry.hpp"
+#include "bg_operators.hpp"
+#include "polygon_index.hpp"
+#include "test_shapes.hpp"
+
+using polygon_index::EdgeIndex;
+using polygon_index::PolygonIndex;
+using polygon_index::PreparedMask;
+
+BOOST_AUTO_TEST_SUITE(polygon_index_tests)
+
+BOOST_AUTO_TEST_CASE(empty) {
+  PolygonIndex index;
+  BOOST_CHECK_EQUAL(index.near(box_type_fp{{0, 0}, {10, 10}}).size(), 0UL);
+  BOOST_CHECK_EQUAL(index.intersection(square(0, 0, 1)).size(), 0UL);
+}
+
+BOOST_AUTO_TEST_CASE(near) {
+  multi_polygon_type_fp squares;
+  for (int i = 0; i < 10; i++) {
+    squares.push_back(square(i * 2, 0, 1).front());
+  }
+  PolygonIndex index(squares);
+  BOOST_CHECK_EQUAL(index.polygons().size(), 10UL);
+  auto found = index.near(box_type_fp{{2.5, 0.5}, {6.5, 0.7}});
+  BOOST_REQUIRE_EQUAL(found.size(), 3UL);
+  // In the original order.
+  BOOST_CHECK_EQUAL(bg::return_envelope<box_type_fp>(found[0]).min_corner().x(), 2);
+  BOOST_CHECK_EQUAL(bg::return_envelope<box_type_fp>(found[1]).min_corner().x(), 4);
+  BOOST_CHECK_EQUAL(bg::return_envelope<box_type_fp>(found[2]).min_corner().x(), 6);
+  BOOST_CHECK_EQUAL(index.near(box_type_fp{{0, 5}, {20, 6}}).size(), 0UL);
+}
+
+BOOST_AUTO_TEST_CASE(intersection) {
+  multi_polygon_type_fp squares;
+  for (int i = 0; i < 10; i++) {
+    squares.push_back(square(i * 2, 0, 1).front());
+  }
+  PolygonIndex index(squares);
+  const auto clip = square(1.5, 0.5, 3);
+  auto result = index.intersection(clip);
+  BOOST_CHECK_CLOSE(bg::area(result), bg::area(squares & clip), 1e-3);
+  BOOST_CHECK_CLOSE(bg::area(result), 0.75, 1e-3);
+}
+
+// A circle with enough points that the mask gets split into quadrants.
+static multi_polygon_type_fp circle(double radius, size_t points) {
+  polygon_type_fp ret;
+  for (size_t i = 0; i < points; i++) {
+    double angle = -2 * M_PI * i / points;
+    ret.outer().push_back(point_type_fp(radius * cos(angle), radius * sin(angle)));
+  }
+  ret.outer().push_back(ret.outer().front());
+  return {ret};
+}
+
+BOOST_AUTO_TEST_CASE(edge_index_empty) {
+  EdgeIndex index;
+  multi_linestring_type_fp paths{{{0, 0}, {1, 1}}};
+  BOOST_CHECK(bg::equals(index.difference(paths), paths));
+}
+
+BOOST_AUTO_TEST_CASE(edge_index_difference) {
+  // A frame with a hole and a square in the hole.
+  multi_polygon_type_fp shapes = square(0, 0, 10) - square(2, 2, 6);
+  shapes.push_back(square(4, 4, 2).front());
+  EdgeIndex index(shapes);
+  BOOST_CHECK_EQUAL(index.polygons().size(), 2UL);
+  const auto check = [&](const multi_linestring_type_fp& paths) {
+    const auto expected = paths - shapes;
+    const auto result = index.difference(paths);
+    BOOST_CHECK_EQUAL(result.size(), expected.size());
+    BOOST_CHECK_CLOSE(bg::length(result), bg::length(expected), 1e-6);
+  };
+  // In the frame, in the hole, in the square and outside everything.
+  check({{{1, 1}, {1, 9}, {9, 9}}});
+  check({{{3, 3}, {3, 7}, {7, 7}}});
+  check({{{4.5, 4.5}, {5.5, 5.5}}});
+  check({{{11, 11}, {12, 12}}, {{-1, 5}, {-1, 6}}});
+  // Level with the corners, which the ray goes through.
+  check({{{-1, 2}, {-0.5, 2}}, {{3, 4}, {3, 6}}, {{1, 8}, {1, 10.5}}});
+  // Across the edges.
+  check({{{-1, 5}, {11, 5}}});
+  check({{{5, -1}, {5, 1}}, {{3, 3}, {3, 4}}});
+}
+
+BOOST_AUTO_TEST_CASE(prepared_mask_empty) {
+  PreparedMask mask({});
+  BOOST_CHECK_EQUAL(mask.clip(box_type_fp{{0, 0}, {1, 1}}).size(), 0UL);
+}
+
+BOOST_AUTO_TEST_CASE(prepared_mask_clip) {
+  auto shape = circle(10, 10000);
+  PreparedMask mask(shape);
+  BOOST_CHECK(bg::equals(mask.envelope(), bg::return_envelope<box_type_fp>(shape)));
+  // Holding the whole mask.
+  auto all = mask.clip(box_type_fp{{-20, -20}, {20, 20}});
+  BOOST_CHECK_EQUAL(bg::num_points(all), bg::num_points(shape));
+  // Across the edge.
+  box_type_fp edge{{9, -1}, {11, 1}};
+  auto clipped = mask.clip(edge);
+  BOOST_CHECK_CLOSE(bg::area(clipped), bg::area(shape & edge), 1e-6);
+  BOOST_CHECK_LT(bg::num_points(clipped), 1000UL);
+  // Inside and outside.
+  BOOST_CHECK_CLOSE(bg::area(mask.clip(box_type_fp{{-1, -1}, {1, 1}})), 4, 1e-6);
+  BOOST_CHECK_EQUAL(mask.clip(box_type_fp{{9.5, 9.5}, {10, 10}}).size(), 0UL);
+  BOOST_CHECK_EQUAL(mask.clip(box_type_fp{{30, 30}, {31, 31}}).size(), 0UL);
+  // Across the middle, which can't use any quadrant.
+  box_type_fp middle{{-5, -1}, {12, 1}};
+  BOOST_CHECK_CLOSE(bg::area(mask.clip(middle)), bg::area(shape & middle), 1e-6);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,41 @@
+#include <algorithm>
+#include <cmath>
+
+#include <boost/math/constants/constants.hpp>
+
+#include "precision.hpp"
+
+namespace precision {
+
+static double max_deviation = 0;
+
+void set_max_deviation(double new_max_deviation) {
+  max_deviation = new_max_deviation;
+}
+
+double get_max_deviation() {
+  return max_deviation;
+}
+
+double points_per_circle(double radius, double chord_length) {
+  const double pi = boost::math::constants::pi<double>();
+  if (max_deviation <= 0) {
+    return std::max(32., radius * 2 * pi / chord_length);
+  }
+  if (radius <= max_deviation) {
+    return 32;
+  }
+  // A side that spans an angle of 2*theta is radius*(1-cos(theta)) from the
+  // circle at its middle.
+  return std::max(32., std::ceil(pi / std::acos(1 - max_deviation / radius)));
+}
+
+double points_per_radian(double radius, double chord_length) {
+  const double pi = boost::math::constants::pi<double>();
+  if (max_deviation <= 0) {
+    return std::max(32. / 2 / pi, radius / chord_length);
+  }
+  return points_per_circle(radius, chord_length) / 2 / pi;
+}
+
+} // namespace precision
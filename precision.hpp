@@ -0,0 +1,24 @@
+#ifndef PRECISION_HPP
+#define PRECISION_HPP
+
+namespace precision {
+
+// Circles, arcs and round buffer joins are all approximated by regular
+// polygons.  By default, the number of points is chosen so that each side is
+// at most a given length.  If a maximum deviation is set, the number of points
+// is instead the fewest for which the polygon stays within that distance of
+// the true circle, which is much fewer for large circles.  Either way, there
+// are at least 32 points.  0 restores the default.
+void set_max_deviation(double max_deviation);
+double get_max_deviation();
+
+// The number of points to use for a circle of the given radius.  chord_length
+// is the side length used when no maximum deviation is set.
+double points_per_circle(double radius, double chord_length);
+
+// The same, but per radian, for arcs.
+double points_per_radian(double radius, double chord_length);
+
+} // namespace precision
+
+#endif // PRECISION_HPP
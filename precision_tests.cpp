@@ -0,0 +1,44 @@
+#define BOOST_TEST_MODULE precision tests
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+
+#include <boost/math/constants/constants.hpp>
+
+#include "precision.hpp"
+
+using precision::points_per_circle;
+using precision::points_per_radian;
+using precision::set_max_deviation;
+
+BOOST_AUTO_TEST_SUITE(precision_tests)
+
+const double pi = boost::math::constants::pi<double>();
+
+BOOST_AUTO_TEST_CASE(chord_length) {
+  set_max_deviation(0);
+  BOOST_CHECK_EQUAL(points_per_circle(0.001, 0.0004), 32);
+  BOOST_CHECK_EQUAL(points_per_circle(-1, 0.0004), 32);
+  BOOST_CHECK_CLOSE(points_per_circle(1, 0.0004), 2 * pi / 0.0004, 1e-9);
+  BOOST_CHECK_CLOSE(points_per_radian(1, 0.0004), 1 / 0.0004, 1e-9);
+  BOOST_CHECK_CLOSE(points_per_radian(0.001, 0.0004), 32 / 2 / pi, 1e-9);
+}
+
+BOOST_AUTO_TEST_CASE(max_deviation) {
+  set_max_deviation(0.0001);
+  for (double radius : {0.00005, 0.001, 0.01, 0.1, 1., 10.}) {
+    const double points = points_per_circle(radius, 0.0004);
+    BOOST_CHECK_GE(points, 32);
+    // The middle of each side is no further than the deviation from the circle.
+    BOOST_CHECK_LE(radius * (1 - std::cos(pi / points)), 0.0001 * (1 + 1e-9));
+    // Fewer points than the chord length would need.
+    BOOST_CHECK_LE(points, std::max(32., 2 * pi * radius / 0.0004));
+    BOOST_CHECK_CLOSE(points_per_radian(radius, 0.0004), points / 2 / pi, 1e-9);
+  }
+  // A 1 inch circle needs only a few hundred points.
+  BOOST_CHECK_LT(points_per_circle(1, 0.0004), 250);
+  set_max_deviation(0);
+  BOOST_CHECK_CLOSE(points_per_circle(1, 0.0004), 2 * pi / 0.0004, 1e-9);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,271 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+#include <boost/lexical_cast.hpp>
+#include <boost/optional.hpp>
+
+#include "bg_helpers.hpp"
+#include "polygon_index.hpp"
+#include "precision.hpp"
+#include "stage_recorder.hpp"
+#include "surface_vectorial.hpp"
+#include "tsp_solver.hpp"
+
+// Runs stages of making the toolpaths that were saved with --record-stage,
+// without the rest of pcb2gcode, and prints how long they took.  This is for
+// benchmarking the stage with real boards.
+
+static box_type_fp recorded_bounding_box(const stage_recorder::Recording& recording) {
+  return box_type_fp(point_type_fp(recording.number("min_x"), recording.number("min_y")),
+                     point_type_fp(recording.number("max_x"), recording.number("max_y")));
+}
+
+// A surface with just what the recorded stage needs, so that its protected
+// stages can be run.
+class Replay : public Surface_vectorial {
+ public:
+  explicit Replay(const stage_recorder::Recording& recording) :
+      Surface_vectorial(recorded_bounding_box(recording), "replay", "",
+                        recording.number("tsp_2opt"),
+                        static_cast<MillFeedDirection::MillFeedDirection>(recording.number("mill_feed_direction")),
+                        recording.number("invert_gerbers"), false),
+      stage(recording.stage()),
+      mill(recording.mill()),
+      max_deviation(recording.number("max_deviation")) {
+    vectorial_surface = std::make_shared<disk_cache::Rendered>();
+    if (recording.has("keep_out")) {
+      if (recording.has("keep_in")) {
+        keep_in = recording.polygons("keep_in");
+      }
+      keep_out = recording.polygons("keep_out");
+      surface_tolerance = recording.number("surface_tolerance");
+    }
+    switch (stage) {
+      case RecordStage::SINGLE_TOOLPATH:
+        load_single_toolpath(recording);
+        break;
+      case RecordStage::PATH_FINDING:
+      case RecordStage::POST_PROCESS:
+        paths = recording.paths(stage == RecordStage::PATH_FINDING ? "paths" : "toolpath");
+        break;
+      case RecordStage::TSP:
+        toolpath = recording.linestrings("toolpath");
+        break;
+      case RecordStage::NONE:
+        throw std::logic_error("Can't replay no stage.");
+    }
+  }
+
+  // pcb2gcode offsets the whole layer once for each tool and then uses the
+  // offsets for all the traces, so they're made here, before any timing, by
+  // running the stage once.  They're kept for all the runs.
+  void make_layer_offsets() {
+    if (whole_layer) {
+      prepare();
+      run();
+    }
+  }
+
+  // Gets ready to run the stage, without anything that is left over from the
+  // previous run except for the offsets of the layer.  This isn't timed.
+  void prepare() {
+    precision::set_max_deviation(max_deviation);
+    path_finding_surface.reset();
+    if (keep_out && stage != RecordStage::PATH_FINDING) {
+      // Path finding remembers what it found so each run needs a new one.
+      path_finding_surface.emplace(keep_in, *keep_out, surface_tolerance);
+    }
+  }
+
+  // Runs the stage once and returns the number of points made.
+  size_t run() {
+    switch (stage) {
+      case RecordStage::SINGLE_TOOLPATH:
+        return count_points(get_single_toolpath(mill, trace_index, mirror, tool_diameter, overlap_width,
+                                                *already_milled, *path_finding_surface, boost::none));
+      case RecordStage::PATH_FINDING: {
+        // Building the surface is part of path finding.
+        const path_finding::PathFindingSurface surface(keep_in, *keep_out, surface_tolerance);
+        return count_points(final_path_finder(mill, surface, paths));
+      }
+      case RecordStage::POST_PROCESS: {
+        boost::optional<const path_finding::PathFindingSurface*> surface;
+        if (path_finding_surface) {
+          surface = &*path_finding_surface;
+        }
+        return bg::num_points(post_process_toolpath(mill, surface, paths));
+      }
+      case RecordStage::TSP: {
+        auto copy = toolpath;
+        if (tsp_2opt) {
+          tsp_solver::tsp_2opt(copy, point_type_fp(0, 0));
+        } else {
+          tsp_solver::nearest_neighbour(copy, point_type_fp(0, 0));
+        }
+        return bg::num_points(copy);
+      }
+      case RecordStage::NONE:
+        break;
+    }
+    return 0;
+  }
+
+ private:
+  void load_single_toolpath(const stage_recorder::Recording& recording) {
+    mirror = recording.number("mirror");
+    tool_diameter = recording.number("tool_diameter");
+    overlap_width = recording.number("overlap_width");
+    already_milled.emplace(recording.polygons("already_milled"));
+    // Only the recorded trace is needed unless the passes are made from
+    // offsets of the whole layer.  The trace is placed at the same index in
+    // the traces, voronoi cells and thermal holes as when it was recorded.
+    auto& traces = vectorial_surface->first;
+    whole_layer = recording.has("layer");
+    if (whole_layer) {
+      traces = recording.polygons("layer");
+    } else if (recording.has("trace")) {
+      traces = recording.polygons("trace");
+    }
+    const bool voronoi_cell = recording.number("voronoi_cell");
+    if (whole_layer) {
+      trace_index = recording.number("trace_index");
+    } else {
+      trace_index = voronoi_cell ? 0 : traces.size();
+    }
+    const auto cell = recording.polygons("cell");
+    if (cell.size() != 1) {
+      throw std::runtime_error("The record in " + recording.directory() + " doesn't have one cell");
+    }
+    voronoi.resize(traces.size());
+    if (voronoi_cell) {
+      voronoi.at(trace_index) = cell.front();
+    } else {
+      thermal_holes.resize(trace_index - traces.size() + 1);
+      thermal_holes.back() = cell.front();
+    }
+    if (recording.has("mask")) {
+      std::shared_ptr<Replay> mask_surface(new Replay(recording, recording.polygons("mask")));
+      prepared_mask.reset(new polygon_index::PreparedMask(mask_surface->vectorial_surface->first));
+      mask = mask_surface;
+    }
+  }
+
+  // Just the shape, for a mask.
+  Replay(const stage_recorder::Recording& recording, const multi_polygon_type_fp& shape) :
+      Surface_vectorial(recorded_bounding_box(recording), "mask", "", false, MillFeedDirection::ANY,
+                        false, false),
+      stage(RecordStage::NONE) {
+    vectorial_surface = std::make_shared<disk_cache::Rendered>();
+    vectorial_surface->first = shape;
+  }
+
+  static size_t count_points(const vector<std::pair<linestring_type_fp, bool>>& paths) {
+    size_t points = 0;
+    for (const auto& path : paths) {
+      points += path.first.size();
+    }
+    return points;
+  }
+
+  const RecordStage::RecordStage stage;
+  std::shared_ptr<RoutingMill> mill;
+  double max_deviation = 0;
+  // For making the surface for path finding, if there is one.
+  boost::optional<multi_polygon_type_fp> keep_in;
+  boost::optional<multi_polygon_type_fp> keep_out;
+  double surface_tolerance = 0;
+  boost::optional<path_finding::PathFindingSurface> path_finding_surface;
+  // For single-toolpath.
+  size_t trace_index = 0;
+  bool whole_layer = false;
+  bool mirror = false;
+  double tool_diameter = 0;
+  double overlap_width = 0;
+  boost::optional<polygon_index::EdgeIndex> already_milled;
+  // For path-finding and post-process.
+  vector<std::pair<linestring_type_fp, bool>> paths;
+  // For tsp.
+  multi_linestring_type_fp toolpath;
+};
+
+static void usage() {
+  std::cerr << "Usage: replay_stage [--runs N] RECORD_DIRECTORY..." << std::endl
+            << "Runs each stage recorded by pcb2gcode --record-stage N times (default 5) and" << std::endl
+            << "prints the time that it took.  All the records must be of the same stage." << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+  unsigned int runs = 5;
+  vector<string> directories;
+  for (int i = 1; i < argc; i++) {
+    const string arg = argv[i];
+    if (arg == "--runs" && i + 1 < argc) {
+      runs = std::strtoul(argv[++i], nullptr, 10);
+    } else if (arg == "--help" || arg == "-h") {
+      usage();
+      return 0;
+    } else {
+      directories.push_back(arg);
+    }
+  }
+  if (directories.empty() || runs == 0) {
+    usage();
+    return 1;
+  }
+  // Otherwise every run after the first would only look up the buffers that
+  // the first one made.
+  bg_helpers::enable_cache(false);
+
+  try {
+    vector<std::unique_ptr<Replay>> replays;
+    boost::optional<RecordStage::RecordStage> stage;
+    for (const auto& directory : directories) {
+      const stage_recorder::Recording recording(directory);
+      if (stage && recording.stage() != *stage) {
+        throw std::runtime_error(directory + " is a record of " +
+                                 boost::lexical_cast<string>(recording.stage()) + ", not " +
+                                 boost::lexical_cast<string>(*stage));
+      }
+      stage = recording.stage();
+      replays.emplace_back(new Replay(recording));
+    }
+
+    for (auto& replay : replays) {
+      replay->make_layer_offsets();
+    }
+
+    std::cout << *stage << ": " << replays.size() << " records, " << runs << " runs" << std::endl;
+    vector<double> seconds;
+    size_t points = 0;
+    for (unsigned int run = 0; run < runs; run++) {
+      std::chrono::steady_clock::duration elapsed{0};
+      points = 0;
+      for (auto& replay : replays) {
+        replay->prepare();
+        const auto start = std::chrono::steady_clock::now();
+        points += replay->run();
+        elapsed += std::chrono::steady_clock::now() - start;
+      }
+      seconds.push_back(std::chrono::duration<double>(elapsed).count());
+      std::cout << "run " << run + 1 << ": " << std::fixed << std::setprecision(6)
+                << seconds.back() << "s" << std::endl;
+    }
+    std::sort(seconds.begin(), seconds.end());
+    std::cout << "min " << seconds.front() << "s, median " << seconds[seconds.size() / 2]
+              << "s, max " << seconds.back() << "s" << std::endl;
+    std::cout << "output points: " << points << std::endl;
+  } catch (const std::exception& e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
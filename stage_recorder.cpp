@@ -0,0 +1,276 @@
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <sys/types.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+#include <boost/format.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include "common.hpp"
+#include "geometry_file.hpp"
+#include "stage_recorder.hpp"
+
+namespace stage_recorder {
+
+using std::runtime_error;
+using std::string;
+using std::vector;
+using std::pair;
+
+static RecordStage::RecordStage recorded_stage = RecordStage::NONE;
+
+void set_stage(RecordStage::RecordStage stage) {
+  recorded_stage = stage;
+}
+
+bool recording(RecordStage::RecordStage stage) {
+  return stage != RecordStage::NONE && stage == recorded_stage;
+}
+
+bool recording_path_finding_surface() {
+  return recording(RecordStage::SINGLE_TOOLPATH) || recording(RecordStage::PATH_FINDING) ||
+      recording(RecordStage::POST_PROCESS);
+}
+
+static const string PARAMETERS_FILENAME = "parameters.txt";
+
+static const string GEOMETRY_EXTENSION = ".geom";
+
+Record::Record(RecordStage::RecordStage stage, const string& outputdir, const string& layer) :
+    Record(stage, outputdir, layer, "record") {}
+
+Record Record::shared(RecordStage::RecordStage stage, const string& outputdir, const string& layer) {
+  return Record(stage, outputdir, layer, "shared");
+}
+
+Record::Record(RecordStage::RecordStage stage, const string& outputdir, const string& layer,
+               const string& kind) :
+    stage(stage) {
+  static std::atomic<unsigned int> count(0);
+  name = (boost::format("%s_%s_%s_%04d") % kind % layer % stage % count.fetch_add(1)).str();
+  directory = build_filename(outputdir, name);
+#ifdef _WIN32
+  const int result = _mkdir(directory.c_str());
+#else
+  const int result = mkdir(directory.c_str(), 0777);
+#endif
+  // A directory left by an earlier run is reused.  Only what's listed in
+  // the parameters is read back so nothing stale is used.
+  if (result != 0 && errno != EEXIST) {
+    throw runtime_error("Can't make the directory " + directory + " for recording");
+  }
+  text("stage", boost::lexical_cast<string>(stage));
+}
+
+Record& Record::number(const string& key, double value) {
+  std::ostringstream out;
+  out << std::setprecision(17) << value;
+  return text(key, out.str());
+}
+
+Record& Record::text(const string& key, const string& value) {
+  parameters[key] = value;
+  return *this;
+}
+
+Record& Record::geometry(const string& key, const multi_polygon_type_fp& mp) {
+  geometry_file::write(build_filename(directory, key + GEOMETRY_EXTENSION), mp);
+  geometry_keys.insert(key);
+  return text(key, key + GEOMETRY_EXTENSION);
+}
+
+Record& Record::geometry(const string& key, const multi_linestring_type_fp& mls) {
+  geometry_file::write(build_filename(directory, key + GEOMETRY_EXTENSION), mls);
+  geometry_keys.insert(key);
+  return text(key, key + GEOMETRY_EXTENSION);
+}
+
+Record& Record::paths(const string& key, const vector<pair<linestring_type_fp, bool>>& paths) {
+  multi_linestring_type_fp mls;
+  mls.reserve(paths.size());
+  string reversible;
+  reversible.reserve(paths.size());
+  for (const auto& path : paths) {
+    mls.push_back(path.first);
+    reversible.push_back(path.second ? '1' : '0');
+  }
+  return geometry(key, mls).text(key + "_reversible", reversible);
+}
+
+Record& Record::mill(const std::shared_ptr<RoutingMill>& mill) {
+  number("feed", mill->feed);
+  number("vertfeed", mill->vertfeed);
+  number("zsafe", mill->zsafe);
+  number("zwork", mill->zwork);
+  number("tolerance", mill->tolerance);
+  number("optimise", mill->optimise);
+  number("eulerian_paths", mill->eulerian_paths);
+  number("path_finding_limit", mill->path_finding_limit);
+  number("g0_vertical_speed", mill->g0_vertical_speed);
+  number("g0_horizontal_speed", mill->g0_horizontal_speed);
+  number("backtrack", mill->backtrack);
+  number("offset", mill->offset);
+  if (const auto isolator = std::dynamic_pointer_cast<Isolator>(mill)) {
+    text("mill", "isolator");
+    number("extra_passes", isolator->extra_passes);
+    number("voronoi", isolator->voronoi);
+    number("isolation_width", isolator->isolation_width);
+    number("layer_offsets", isolator->layer_offsets);
+    number("draft_resolution", isolator->draft_resolution);
+  } else if (const auto cutter = std::dynamic_pointer_cast<Cutter>(mill)) {
+    text("mill", "cutter");
+    number("tool_diameter", cutter->tool_diameter);
+  }
+  return *this;
+}
+
+Record& Record::path_finding_surface(const path_finding::PathFindingSurface& surface) {
+  if (!surface.kept_inputs()) {
+    throw runtime_error("The path finding surface didn't keep what it was made from");
+  }
+  if (surface.keep_in()) {
+    geometry("keep_in", *surface.keep_in());
+  }
+  return geometry("keep_out", surface.keep_out()).number("surface_tolerance", surface.tolerance());
+}
+
+Record& Record::refer_to(const Record& shared) {
+  for (const auto& parameter : shared.parameters) {
+    if (parameter.first == "stage") {
+      continue;
+    }
+    if (shared.geometry_keys.count(parameter.first) > 0) {
+      // The geometry file names are relative to the record's directory.
+      text(parameter.first, build_filename(build_filename("..", shared.name), parameter.second));
+    } else {
+      text(parameter.first, parameter.second);
+    }
+  }
+  return *this;
+}
+
+void Record::save() const {
+  const string filename = build_filename(directory, PARAMETERS_FILENAME);
+  std::ofstream out(filename);
+  for (const auto& parameter : parameters) {
+    out << parameter.first << " " << parameter.second << "\n";
+  }
+  out.close();
+  if (!out) {
+    throw runtime_error("Can't write " + filename);
+  }
+}
+
+Recording::Recording(const string& directory) : directory_(directory) {
+  const string filename = build_filename(directory, PARAMETERS_FILENAME);
+  std::ifstream in(filename);
+  if (!in) {
+    throw runtime_error("Can't read " + filename);
+  }
+  string line;
+  while (std::getline(in, line)) {
+    const auto space = line.find(' ');
+    if (space == string::npos) {
+      throw runtime_error("Can't parse the line \"" + line + "\" in " + filename);
+    }
+    parameters[line.substr(0, space)] = line.substr(space + 1);
+  }
+  std::istringstream stage_text(text("stage"));
+  try {
+    stage_text >> stage_;
+  } catch (const std::exception&) {
+    throw runtime_error("Unknown stage " + text("stage") + " in " + filename);
+  }
+}
+
+// The geometry is in the file named by the parameter.
+string Recording::geometry_filename(const string& key) const {
+  return build_filename(directory_, text(key));
+}
+
+bool Recording::has(const string& key) const {
+  return parameters.count(key) > 0;
+}
+
+const string& Recording::text(const string& key) const {
+  const auto found = parameters.find(key);
+  if (found == parameters.cend()) {
+    throw runtime_error("The record in " + directory_ + " has no " + key);
+  }
+  return found->second;
+}
+
+double Recording::number(const string& key) const {
+  const string& value = text(key);
+  char* end;
+  const double result = std::strtod(value.c_str(), &end);
+  if (value.empty() || *end != '\0') {
+    throw runtime_error("The record in " + directory_ + " has " + key + " " + value +
+                        ", which isn't a number");
+  }
+  return result;
+}
+
+multi_polygon_type_fp Recording::polygons(const string& key) const {
+  return geometry_file::Reader(geometry_filename(key)).multi_polygon();
+}
+
+multi_linestring_type_fp Recording::linestrings(const string& key) const {
+  return geometry_file::Reader(geometry_filename(key)).multi_linestring();
+}
+
+vector<pair<linestring_type_fp, bool>> Recording::paths(const string& key) const {
+  const auto mls = linestrings(key);
+  const string& reversible = text(key + "_reversible");
+  if (reversible.size() != mls.size()) {
+    throw runtime_error("The record in " + directory_ + " has the wrong number of " + key);
+  }
+  vector<pair<linestring_type_fp, bool>> paths;
+  paths.reserve(mls.size());
+  for (size_t i = 0; i < mls.size(); i++) {
+    paths.emplace_back(mls[i], reversible[i] == '1');
+  }
+  return paths;
+}
+
+std::shared_ptr<RoutingMill> Recording::mill() const {
+  std::shared_ptr<RoutingMill> mill;
+  if (text("mill") == "isolator") {
+    auto isolator = std::make_shared<Isolator>();
+    isolator->extra_passes = number("extra_passes");
+    isolator->voronoi = number("voronoi");
+    isolator->isolation_width = number("isolation_width");
+    isolator->layer_offsets = number("layer_offsets");
+    isolator->draft_resolution = number("draft_resolution");
+    mill = isolator;
+  } else if (text("mill") == "cutter") {
+    auto cutter = std::make_shared<Cutter>();
+    cutter->tool_diameter = number("tool_diameter");
+    mill = cutter;
+  } else {
+    throw runtime_error("Unknown mill " + text("mill") + " in " + directory_);
+  }
+  mill->feed = number("feed");
+  mill->vertfeed = number("vertfeed");
+  mill->zsafe = number("zsafe");
+  mill->zwork = number("zwork");
+  mill->tolerance = number("tolerance");
+  mill->optimise = number("optimise");
+  mill->eulerian_paths = number("eulerian_paths");
+  mill->path_finding_limit = number("path_finding_limit");
+  mill->g0_vertical_speed = number("g0_vertical_speed");
+  mill->g0_horizontal_speed = number("g0_horizontal_speed");
+  mill->backtrack = number("backtrack");
+  mill->offset = number("offset");
+  return mill;
+}
+
+} // namespace stage_recorder
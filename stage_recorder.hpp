@@ -0,0 +1,91 @@
+#ifndef STAGE_RECORDER_HPP
+#define STAGE_RECORDER_HPP
+
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "geometry.hpp"
+#include "mill.hpp"
+#include "path_finding.hpp"
+#include "units.hpp"
+
+namespace stage_recorder {
+
+// Saves the exact inputs of one stage of making the toolpaths, every time
+// that it runs, so that the stage can be replayed on its own with
+// replay_stage.  Nothing is recorded for RecordStage::NONE, the default.
+void set_stage(RecordStage::RecordStage stage);
+bool recording(RecordStage::RecordStage stage);
+// Whether the recorded stage uses a path finding surface, which must then
+// keep its inputs so that they can be recorded.
+bool recording_path_finding_surface();
+
+// The inputs of one run of a stage, in a new directory in the output
+// directory named after the layer, the stage and a counter.  The numbers and
+// strings go in a text file and the geometry in geometry files.  Throws
+// std::runtime_error if it can't be written.
+class Record {
+ public:
+  Record(RecordStage::RecordStage stage, const std::string& outputdir, const std::string& layer);
+  // For what many records of the stage have in common, like the whole layer
+  // for each trace's record, so that it's written only once.  It's never
+  // saved on its own.  Records get it with refer_to().
+  static Record shared(RecordStage::RecordStage stage, const std::string& outputdir,
+                       const std::string& layer);
+  Record& number(const std::string& key, double value);
+  Record& text(const std::string& key, const std::string& value);
+  Record& geometry(const std::string& key, const multi_polygon_type_fp& mp);
+  Record& geometry(const std::string& key, const multi_linestring_type_fp& mls);
+  // Each path with whether it may be reversed.
+  Record& paths(const std::string& key, const std::vector<std::pair<linestring_type_fp, bool>>& paths);
+  // The settings of the mill that are used for making toolpaths.
+  Record& mill(const std::shared_ptr<RoutingMill>& mill);
+  // The surface must have kept its inputs.
+  Record& path_finding_surface(const path_finding::PathFindingSurface& surface);
+  // Adds everything in the shared record, with the geometry read from its
+  // directory.
+  Record& refer_to(const Record& shared);
+  // Writes the numbers and strings.  Nothing is complete until this is called.
+  void save() const;
+
+ private:
+  Record(RecordStage::RecordStage stage, const std::string& outputdir, const std::string& layer,
+         const std::string& kind);
+  const RecordStage::RecordStage stage;
+  // The directory's name in the output directory and its path.
+  std::string name;
+  std::string directory;
+  std::map<std::string, std::string> parameters;
+  std::set<std::string> geometry_keys;
+};
+
+// A record that was saved.  Throws std::runtime_error if it can't be read or
+// something is missing from it.
+class Recording {
+ public:
+  explicit Recording(const std::string& directory);
+  RecordStage::RecordStage stage() const { return stage_; }
+  const std::string& directory() const { return directory_; }
+  bool has(const std::string& key) const;
+  double number(const std::string& key) const;
+  const std::string& text(const std::string& key) const;
+  multi_polygon_type_fp polygons(const std::string& key) const;
+  multi_linestring_type_fp linestrings(const std::string& key) const;
+  std::vector<std::pair<linestring_type_fp, bool>> paths(const std::string& key) const;
+  // An Isolator or a Cutter, with the settings that were recorded.
+  std::shared_ptr<RoutingMill> mill() const;
+
+ private:
+  std::string geometry_filename(const std::string& key) const;
+  std::string directory_;
+  RecordStage::RecordStage stage_;
+  std::map<std::string, std::string> parameters;
+};
+
+} // namespace stage_recorder
+
+#endif // STAGE_RECORDER_HPP
@@ -0,0 +1,123 @@
+#define BOOST_TEST_MODULE stage recorder tests
+#include <boost/test/unit_test.hpp>
+
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+#include <boost/lexical_cast.hpp>
+
+#include "stage_recorder.hpp"
+
+using stage_recorder::Record;
+using stage_recorder::Recording;
+
+BOOST_AUTO_TEST_SUITE(stage_recorder_tests)
+
+// The records go in the current directory, named after the layer, the stage
+// and a counter that starts from 0.
+BOOST_AUTO_TEST_CASE(recording) {
+  stage_recorder::set_stage(RecordStage::NONE);
+  BOOST_CHECK(!stage_recorder::recording(RecordStage::NONE));
+  BOOST_CHECK(!stage_recorder::recording(RecordStage::TSP));
+  stage_recorder::set_stage(RecordStage::TSP);
+  BOOST_CHECK(stage_recorder::recording(RecordStage::TSP));
+  BOOST_CHECK(!stage_recorder::recording(RecordStage::POST_PROCESS));
+  stage_recorder::set_stage(RecordStage::NONE);
+}
+
+BOOST_AUTO_TEST_CASE(round_trip) {
+  multi_polygon_type_fp mp;
+  bg::read_wkt("MULTIPOLYGON(((0 0,0 10,10 10,10 0,0 0),(2 2,8 2,8 8,2 8,2 2)))", mp);
+  std::vector<std::pair<linestring_type_fp, bool>> paths(2);
+  bg::read_wkt("LINESTRING(0 0,1 1,2 0)", paths[0].first);
+  paths[0].second = true;
+  bg::read_wkt("LINESTRING(5 5,6 6)", paths[1].first);
+  paths[1].second = false;
+
+  Record record(RecordStage::POST_PROCESS, "", "round_trip");
+  record.number("third", 1.0/3).number("infinite", std::numeric_limits<double>::infinity())
+      .text("words", "two words").geometry("mp", mp).paths("paths", paths)
+      .paths("no_paths", {});
+  record.save();
+
+  const Recording recording("record_round_trip_post-process_0000");
+  BOOST_CHECK_EQUAL(recording.stage(), RecordStage::POST_PROCESS);
+  BOOST_CHECK_EQUAL(recording.number("third"), 1.0/3);
+  BOOST_CHECK_EQUAL(recording.number("infinite"), std::numeric_limits<double>::infinity());
+  BOOST_CHECK_EQUAL(recording.text("words"), "two words");
+  BOOST_CHECK_THROW(recording.number("words"), std::runtime_error);
+  BOOST_CHECK(recording.has("mp"));
+  BOOST_CHECK(!recording.has("missing"));
+  BOOST_CHECK_THROW(recording.number("missing"), std::runtime_error);
+  BOOST_CHECK_THROW(recording.polygons("missing"), std::runtime_error);
+  BOOST_CHECK(bg::equals(recording.polygons("mp"), mp));
+  BOOST_CHECK_THROW(recording.linestrings("mp"), std::runtime_error);
+  const auto loaded_paths = recording.paths("paths");
+  BOOST_REQUIRE_EQUAL(loaded_paths.size(), 2);
+  for (size_t i = 0; i < paths.size(); i++) {
+    BOOST_CHECK_EQUAL(boost::lexical_cast<std::string>(bg::wkt(loaded_paths[i].first)),
+                      boost::lexical_cast<std::string>(bg::wkt(paths[i].first)));
+    BOOST_CHECK_EQUAL(loaded_paths[i].second, paths[i].second);
+  }
+  BOOST_CHECK(recording.paths("no_paths").empty());
+}
+
+BOOST_AUTO_TEST_CASE(mills) {
+  auto isolator = std::make_shared<Isolator>();
+  isolator->feed = 10;
+  isolator->backtrack = std::numeric_limits<double>::infinity();
+  isolator->path_finding_limit = 100;
+  isolator->extra_passes = 2;
+  isolator->voronoi = true;
+  isolator->draft_resolution = 0.001;
+  Record(RecordStage::SINGLE_TOOLPATH, "", "isolator").mill(isolator).save();
+  const auto loaded_isolator = std::dynamic_pointer_cast<Isolator>(
+      Recording("record_isolator_single-toolpath_0001").mill());
+  BOOST_REQUIRE(loaded_isolator);
+  BOOST_CHECK_EQUAL(loaded_isolator->feed, 10);
+  BOOST_CHECK_EQUAL(loaded_isolator->backtrack, std::numeric_limits<double>::infinity());
+  BOOST_CHECK_EQUAL(loaded_isolator->path_finding_limit, 100);
+  BOOST_CHECK_EQUAL(loaded_isolator->extra_passes, 2);
+  BOOST_CHECK(loaded_isolator->voronoi);
+  BOOST_CHECK_EQUAL(loaded_isolator->draft_resolution, 0.001);
+
+  auto cutter = std::make_shared<Cutter>();
+  cutter->tool_diameter = 0.125;
+  Record(RecordStage::POST_PROCESS, "", "cutter").mill(cutter).save();
+  const auto loaded_cutter = std::dynamic_pointer_cast<Cutter>(
+      Recording("record_cutter_post-process_0002").mill());
+  BOOST_REQUIRE(loaded_cutter);
+  BOOST_CHECK_EQUAL(loaded_cutter->tool_diameter, 0.125);
+}
+
+BOOST_AUTO_TEST_CASE(invalid) {
+  BOOST_CHECK_THROW(Recording("no_such_record"), std::runtime_error);
+  Record(RecordStage::TSP, "", "invalid").save();
+  std::ofstream("record_invalid_tsp_0003/parameters.txt") << "stage something\n";
+  BOOST_CHECK_THROW(Recording("record_invalid_tsp_0003"), std::runtime_error);
+  std::ofstream("record_invalid_tsp_0003/parameters.txt") << "stage\n";
+  BOOST_CHECK_THROW(Recording("record_invalid_tsp_0003"), std::runtime_error);
+}
+
+// The geometry that records have in common is written once and each record
+// reads it from there.
+BOOST_AUTO_TEST_CASE(shared) {
+  multi_polygon_type_fp layer;
+  bg::read_wkt("MULTIPOLYGON(((0 0,0 10,10 10,10 0,0 0)))", layer);
+  auto shared = Record::shared(RecordStage::SINGLE_TOOLPATH, "", "shared");
+  shared.geometry("layer", layer).number("surface_tolerance", 0.5);
+  Record(RecordStage::SINGLE_TOOLPATH, "", "shared").refer_to(shared).number("trace_index", 1).save();
+  Record(RecordStage::SINGLE_TOOLPATH, "", "shared").refer_to(shared).number("trace_index", 2).save();
+  for (const auto& directory : {"record_shared_single-toolpath_0005", "record_shared_single-toolpath_0006"}) {
+    const Recording recording(directory);
+    BOOST_CHECK_EQUAL(recording.stage(), RecordStage::SINGLE_TOOLPATH);
+    BOOST_CHECK(bg::equals(recording.polygons("layer"), layer));
+    BOOST_CHECK_EQUAL(recording.number("surface_tolerance"), 0.5);
+  }
+  BOOST_CHECK_EQUAL(Recording("record_shared_single-toolpath_0006").number("trace_index"), 2);
+  BOOST_CHECK(!std::ifstream("record_shared_single-toolpath_0005/layer.geom"));
+  BOOST_CHECK_THROW(Recording("shared_shared_single-toolpath_0004"), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,58 @@
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "stats.hpp"
+
+namespace stats {
+
+static bool stats_enabled = false;
+static std::mutex stats_mutex;
+static std::vector<std::pair<std::string, size_t>> counters;
+static std::map<std::string, size_t> counter_indices;
+
+void enable(bool enabled) {
+  stats_enabled = enabled;
+}
+
+bool enabled() {
+  return stats_enabled;
+}
+
+void add(const std::string& name, size_t value) {
+  if (!stats_enabled) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(stats_mutex);
+  const auto index = counter_indices.find(name);
+  if (index == counter_indices.cend()) {
+    counter_indices[name] = counters.size();
+    counters.emplace_back(name, value);
+  } else {
+    counters[index->second].second += value;
+  }
+}
+
+Timer::Timer(const std::string& name) {
+  if (stats_enabled) {
+    this->name = name;
+    start = std::chrono::steady_clock::now();
+  }
+}
+
+Timer::~Timer() {
+  if (!name.empty()) {
+    add(name, std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count());
+  }
+}
+
+void report(std::ostream& out) {
+  std::lock_guard<std::mutex> lock(stats_mutex);
+  for (const auto& counter : counters) {
+    out << counter.first << ": " << counter.second << "\n";
+  }
+}
+
+} // namespace stats
@@ -0,0 +1,37 @@
+#ifndef STATS_HPP
+#define STATS_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <string>
+
+namespace stats {
+
+// Counters about each stage of processing, such as the number of vertices,
+// for tuning the speed and precision.  Nothing is counted unless enabled.
+void enable(bool enabled);
+bool enabled();
+
+// Add value to the counter with the given name.
+void add(const std::string& name, size_t value);
+
+// Print all the counters, in the order that they were first added.
+void report(std::ostream& out);
+
+// Adds the microseconds from when it's made until it's destroyed to the
+// counter with the given name, if counting is enabled.  The name should end
+// in "microseconds".
+class Timer {
+ public:
+  explicit Timer(const std::string& name);
+  ~Timer();
+
+ private:
+  std::string name;
+  std::chrono::steady_clock::time_point start;
+};
+
+} // namespace stats
+
+#endif // STATS_HPP
@@ -73,6 +73,11 @@ using boost::make_optional;
 #include "trim_paths.hpp"
 #include "svg_writer.hpp"
 #include "disjoint_set.hpp"
+#include "stats.hpp"
+#include "parallel.hpp"
+#include "debug_output.hpp"
+#include "precision.hpp"
+#include "stage_recorder.hpp"
 
 using std::max;
 using std::max_element;
@@ -95,7 +100,23 @@ Surface_vectorial::Surface_vectorial(const box_type_fp& bounding_box,
     render_paths_to_shapes(render_paths_to_shapes) {}
 
 void Surface_vectorial::render(shared_ptr<GerberImporter> importer, double tolerance) {
-  auto vectorial_surface_not_simplified = importer->render(fill, render_paths_to_shapes);
+  const stats::Timer timer(name + " render microseconds");
+  // Rendering depends only on the file and the precision of the shapes.
+  disk_cache::Key key("render", disk_cache::RENDER_VERSION);
+  key.add(importer->get_max_arc_segment_length()).add(precision::get_max_deviation())
+      .add(fill).add(render_paths_to_shapes);
+  const bool cacheable = disk_cache::enabled() && key.add_file(importer->get_filename());
+  boost::optional<disk_cache::Rendered> cached;
+  if (cacheable) {
+    cached = disk_cache::load<disk_cache::Rendered>(key);
+  }
+  if (!cached) {
+    cached = importer->render(fill, render_paths_to_shapes);
+    if (cacheable) {
+      disk_cache::save(key, *cached);
+    }
+  }
+  auto& vectorial_surface_not_simplified = *cached;
 
   if (bg::intersects(vectorial_surface_not_simplified.first)) {
     cerr << "\nWarning: Geometry of layer '" << name << "' is"
@@ -122,6 +143,10 @@ void Surface_vectorial::render(shared_ptr<GerberImporter> importer, double toler
       vectorial_surface->second[diameter_and_path.first].swap(diameter_and_path.second);
     }
   }
+  if (stats::enabled()) {
+    stats::add(name + " imported vertices", bg::num_points(vectorial_surface_not_simplified.first));
+    stats::add(name + " simplified vertices", bg::num_points(vectorial_surface->first));
+  }
 }
 
 // If the direction is ccw, return cw and vice versa.  If any, return any.
@@ -153,25 +178,40 @@ multi_linestring_type_fp mirror_toolpath(const multi_linestring_type_fp& mls, bo
 }
 
 // Find all potential thermal reliefs.  Those are usually holes in traces.
-// Return those shapes as rings with correct orientation.
+// Return those shapes as rings with correct orientation.  Each hole is only
+// checked against the shapes near it and the holes are checked in parallel.
 vector<polygon_type_fp> find_thermal_reliefs(const multi_polygon_type_fp& milling_surface,
                                              const coordinate_type_fp tolerance) {
-  // For each shape, see if it has any holes that are empty.
-  vector<polygon_type_fp> holes;
+  vector<ring_type_fp> thermal_holes;
   for (const auto& p : milling_surface) {
     for (const auto& inner : p.inners()) {
-      auto thermal_hole = inner;
-      bg::correct(thermal_hole); // Convert it from a hole to a filled-in shape.
-      multi_polygon_type_fp shrunk_thermal_hole = 
-          bg_helpers::buffer_miter(thermal_hole, -tolerance);
-      bool empty_hole = !bg::intersects(shrunk_thermal_hole, milling_surface);
-      if (!empty_hole) {
+      thermal_holes.push_back(inner);
+      bg::correct(thermal_holes.back()); // Convert it from a hole to a filled-in shape.
+    }
+  }
+  const polygon_index::PolygonIndex milling_surface_index(milling_surface);
+  // For each shape, see if it has any holes that are empty.
+  vector<char> empty_holes(thermal_holes.size());
+  parallel::for_ranges(thermal_holes.size(), parallel::hardware_threads(), [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      multi_polygon_type_fp shrunk_thermal_hole =
+          bg_helpers::buffer_miter(thermal_holes[i], -tolerance);
+      if (shrunk_thermal_hole.empty()) {
+        empty_holes[i] = true;
         continue;
       }
-      polygon_type_fp p;
-      p.outer() = thermal_hole;
-      holes.push_back(p);
+      const auto nearby = milling_surface_index.near(bg::return_envelope<box_type_fp>(shrunk_thermal_hole));
+      empty_holes[i] = !bg::intersects(shrunk_thermal_hole, nearby);
+    }
+  });
+  vector<polygon_type_fp> holes;
+  for (size_t i = 0; i < thermal_holes.size(); i++) {
+    if (!empty_holes[i]) {
+      continue;
     }
+    polygon_type_fp p;
+    p.outer() = thermal_holes[i];
+    holes.push_back(p);
   }
   return holes;
 }
@@ -190,52 +230,82 @@ void Surface_vectorial::write_svgs(const std::string& tool_suffix, coordinate_ty
 void Surface_vectorial::write_svgs(const string& tool_suffix, coordinate_type_fp tool_diameter,
                                    const vector<vector<pair<linestring_type_fp, bool>>>& new_trace_toolpaths,
                                    coordinate_type_fp tolerance, bool find_contentions) const {
-  // Now set up the debug images, one per tool.
-  svg_writer debug_image(build_filename(outputdir, "processed_" + name + tool_suffix + ".svg"), bounding_box);
-  svg_writer traced_debug_image(build_filename(outputdir, "traced_" + name + tool_suffix + ".svg"), bounding_box);
-  optional<svg_writer> contentions_image;
-  srand(1);
-  debug_image.add(voronoi, 0.2, false);
-  srand(1);
   const auto trace_count = new_trace_toolpaths.size();
-  for (size_t trace_index = 0; trace_index < trace_count; trace_index++) {
-    const auto& new_trace_toolpath = new_trace_toolpaths[trace_index];
-    const unsigned int r = rand() % 256;
-    const unsigned int g = rand() % 256;
-    const unsigned int b = rand() % 256;
-    for (const auto& ls_and_allow_reversal : new_trace_toolpath) {
-      debug_image.add(ls_and_allow_reversal.first, tool_diameter, r, g, b);
-      traced_debug_image.add(ls_and_allow_reversal.first, tool_diameter, r, g, b);
-    }
-
-    if (find_contentions) {
-      if (trace_index < vectorial_surface->first.size()) {
+  // For each trace, the parts of its toolpath that are too close to it.
+  vector<multi_linestring_type_fp> contentions(trace_count);
+  bool any_contentions = false;
+  if (find_contentions && debug_output::contentions()) {
+    const auto& traces = vectorial_surface->first;
+    parallel::for_ranges(std::min(trace_count, traces.size()), parallel::hardware_threads(),
+                         [&](size_t begin, size_t end) {
+      for (size_t trace_index = begin; trace_index < end; trace_index++) {
         multi_polygon_type_fp temp =
-            bg_helpers::buffer(vectorial_surface->first.at(trace_index), tool_diameter/2 - tolerance);
+            bg_helpers::buffer(traces.at(trace_index), tool_diameter/2 - tolerance);
         multi_linestring_type_fp temp2;
-        for (const auto& ls_and_allow_reversal : new_trace_toolpath) {
+        for (const auto& ls_and_allow_reversal : new_trace_toolpaths[trace_index]) {
           temp2.push_back(ls_and_allow_reversal.first);
         }
         temp2 = temp2 & temp;
         if (bg::length(temp2) > 0) {
-          if (!contentions_image) {
-            contentions_image.emplace(build_filename(outputdir, "contentions_" + name + tool_suffix + ".svg"), bounding_box);
-          }
-          contentions_image->add(temp2, tool_diameter, 255, 0, 0);
+          contentions[trace_index] = temp2;
         }
       }
+    });
+    for (const auto& contention : contentions) {
+      any_contentions = any_contentions || !contention.empty();
     }
   }
-  if (contentions_image) {
+  if (any_contentions) {
+    found_contentions = true;
     cerr << "\nWarning: pcb2gcode hasn't been able to fulfill all"
         " clearance requirements.  Check the contentions output"
         " and consider using a smaller milling bit.\n";
   }
-  srand(1);
-  debug_image.add(vectorial_surface->first, 1, true);
-  for (const auto& diameter_and_path : vectorial_surface->second) {
-    debug_image.add(diameter_and_path.second, diameter_and_path.first, true);
+  const bool write_images = debug_output::images();
+  if (!write_images && !any_contentions) {
+    return;
   }
+
+  // The images are drawn in the background from copies of everything.
+  const auto processed_filename = build_filename(outputdir, "processed_" + name + tool_suffix + ".svg");
+  const auto traced_filename = build_filename(outputdir, "traced_" + name + tool_suffix + ".svg");
+  const auto contentions_filename = build_filename(outputdir, "contentions_" + name + tool_suffix + ".svg");
+  const auto bounding_box = this->bounding_box;
+  const auto voronoi = this->voronoi;
+  const auto surface = *vectorial_surface;
+  debug_output::write([=]() {
+    if (any_contentions) {
+      svg_writer contentions_image(contentions_filename, bounding_box);
+      for (const auto& contention : contentions) {
+        if (!contention.empty()) {
+          contentions_image.add(contention, tool_diameter, 255, 0, 0);
+        }
+      }
+    }
+    if (!write_images) {
+      return;
+    }
+    // Now set up the debug images, one per tool.
+    svg_writer debug_image(processed_filename, bounding_box);
+    svg_writer traced_debug_image(traced_filename, bounding_box);
+    srand(1);
+    debug_image.add(voronoi, 0.2, false);
+    srand(1);
+    for (const auto& new_trace_toolpath : new_trace_toolpaths) {
+      const unsigned int r = rand() % 256;
+      const unsigned int g = rand() % 256;
+      const unsigned int b = rand() % 256;
+      for (const auto& ls_and_allow_reversal : new_trace_toolpath) {
+        debug_image.add(ls_and_allow_reversal.first, tool_diameter, r, g, b);
+        traced_debug_image.add(ls_and_allow_reversal.first, tool_diameter, r, g, b);
+      }
+    }
+    srand(1);
+    debug_image.add(surface.first, 1, true);
+    for (const auto& diameter_and_path : surface.second) {
+      debug_image.add(diameter_and_path.second, diameter_and_path.first, true);
+    }
+  });
 }
 
 vector<pair<linestring_type_fp, bool>> full_eulerian_paths(
@@ -270,7 +340,15 @@ multi_linestring_type_fp Surface_vectorial::post_process_toolpath(
     const std::shared_ptr<RoutingMill>& mill,
     const boost::optional<const path_finding::PathFindingSurface*>& path_finding_surface,
     vector<pair<linestring_type_fp, bool>> toolpath1) const {
+  if (stage_recorder::recording(RecordStage::POST_PROCESS)) {
+    auto post_process_record = record(RecordStage::POST_PROCESS, mill);
+    if (path_finding_surface) {
+      post_process_record.path_finding_surface(**path_finding_surface);
+    }
+    post_process_record.paths("toolpath", toolpath1).save();
+  }
   if (mill->eulerian_paths) {
+    const stats::Timer timer(name + " eulerian paths microseconds");
     toolpath1 = full_eulerian_paths(mill, toolpath1);
   }
   if (path_finding_surface) {
@@ -278,6 +356,7 @@ multi_linestring_type_fp Surface_vectorial::post_process_toolpath(
     if (extra_paths.size() > 0) {
       toolpath1.insert(toolpath1.cend(), extra_paths.cbegin(), extra_paths.cend());
       if (mill->eulerian_paths) {
+        const stats::Timer timer(name + " eulerian paths microseconds");
         toolpath1 = full_eulerian_paths(mill, toolpath1);
       }
     }
@@ -289,6 +368,10 @@ multi_linestring_type_fp Surface_vectorial::post_process_toolpath(
   }
   shared_ptr<Isolator> isolator = dynamic_pointer_cast<Isolator>(mill);
   if (isolator != nullptr) {
+    if (stage_recorder::recording(RecordStage::TSP)) {
+      record(RecordStage::TSP, mill).geometry("toolpath", combined_toolpath).save();
+    }
+    const stats::Timer timer(name + " tsp microseconds");
     if (tsp_2opt) {
       tsp_solver::tsp_2opt(combined_toolpath, point_type_fp(0, 0));
     } else {
@@ -513,9 +596,9 @@ void attach_ls(const linestring_type_fp& ls,
 void attach_mls(const multi_linestring_type_fp& mls,
                 vector<pair<linestring_type_fp, bool>>& toolpaths,
                 const MillFeedDirection::MillFeedDirection& dir,
-                const multi_polygon_type_fp& already_milled_shrunk,
+                const polygon_index::EdgeIndex& already_milled_shrunk,
                 const Surface_vectorial::PathFinder& path_finder) {
-  auto mls_masked = mls - already_milled_shrunk;  // This might chop the single path into many paths.
+  auto mls_masked = already_milled_shrunk.difference(mls);  // This might chop the single path into many paths.
   mls_masked = eulerian_paths::make_eulerian_paths(mls_masked, dir == MillFeedDirection::ANY, false); // Rejoin those paths as possible.
   for (const auto& ls : mls_masked) { // Maybe more than one if the masking cut one into parts.
     attach_ls(ls, toolpaths, dir, path_finder);
@@ -653,7 +736,7 @@ static void add_spikes(ring_type_fp& ring, coordinate_type_fp offset,
 void attach_ring(const ring_type_fp& ring,
                  vector<pair<linestring_type_fp, bool>>& toolpaths,
                  const MillFeedDirection::MillFeedDirection& dir,
-                 const multi_polygon_type_fp& already_milled_shrunk,
+                 const polygon_index::EdgeIndex& already_milled_shrunk,
                  const Surface_vectorial::PathFinder& path_finder,
                  const coordinate_type_fp spike_offset,
                  const bool reverse_spikes,
@@ -673,7 +756,7 @@ void attach_ring(const ring_type_fp& ring,
 void attach_polygons(const multi_polygon_type_fp& polygons,
                      vector<pair<linestring_type_fp, bool>>& toolpaths,
                      const MillFeedDirection::MillFeedDirection& dir,
-                     const multi_polygon_type_fp& already_milled_shrunk,
+                     const polygon_index::EdgeIndex& already_milled_shrunk,
                      const Surface_vectorial::PathFinder& path_finder,
                      const coordinate_type_fp spike_offset,
                      const bool reverse_spikes,
@@ -751,6 +834,43 @@ Surface_vectorial::PathFinderRingIndices Surface_vectorial::make_path_finder_rin
          };
 }
 
+stage_recorder::Record Surface_vectorial::record(RecordStage::RecordStage stage,
+                                                 const shared_ptr<RoutingMill>& mill) const {
+  stage_recorder::Record record(stage, outputdir, name);
+  record.mill(mill)
+      .number("min_x", bounding_box.min_corner().x()).number("min_y", bounding_box.min_corner().y())
+      .number("max_x", bounding_box.max_corner().x()).number("max_y", bounding_box.max_corner().y())
+      .number("tsp_2opt", tsp_2opt).number("mill_feed_direction", mill_feed_direction)
+      .number("invert_gerbers", invert_gerbers)
+      .number("max_deviation", precision::get_max_deviation());
+  return record;
+}
+
+// What all the single toolpath records for one tool have in common, or none if
+// they aren't being recorded.
+optional<stage_recorder::Record> Surface_vectorial::single_toolpath_shared_record(
+    const shared_ptr<RoutingMill>& mill,
+    const path_finding::PathFindingSurface& path_finding_surface) const {
+  if (!stage_recorder::recording(RecordStage::SINGLE_TOOLPATH)) {
+    return boost::none;
+  }
+  auto shared_record = stage_recorder::Record::shared(RecordStage::SINGLE_TOOLPATH, outputdir, name);
+  shared_record.path_finding_surface(path_finding_surface);
+  if (uses_layer_offsets(mill)) {
+    // The passes are cut from offsets of the whole layer.
+    shared_record.geometry("layer", vectorial_surface->first);
+  }
+  if (mask) {
+    shared_record.geometry("mask", mask->vectorial_surface->first);
+  }
+  return shared_record;
+}
+
+bool Surface_vectorial::uses_layer_offsets(const shared_ptr<RoutingMill>& mill) {
+  const auto isolator = dynamic_pointer_cast<Isolator>(mill);
+  return isolator && (isolator->layer_offsets || isolator->draft_resolution > 0);
+}
+
 // Get all the toolpaths for a single milling bit for just one of the traces or
 // thermal holes.  The mill is the tool to use and the tool_diameter and the
 // overlap_width are the specifics of the tool to use in the milling.  mirror
@@ -758,14 +878,17 @@ Surface_vectorial::PathFinderRingIndices Surface_vectorial::make_path_finder_rin
 // it will be on the back.  The tool_suffix is for making unique filenames if
 // there are multiple tools.  The already_milled_shrunk is the running union of
 // all the milled area so far, so that new milling can avoid re-milling areas
-// that are already milled.  Returns each pass' toolpath with a boolean
+// that are already milled.  It is indexed so that each ring is only masked by
+// the milled area near it.  Returns each pass' toolpath with a boolean
 // indicating if the path can be reversed.  True means reversal is allowed and
-// false means that it isn't.
+// false means that it isn't.  The shared_record is what the tool's records
+// have in common, if it's being recorded.
 vector<pair<linestring_type_fp, bool>> Surface_vectorial::get_single_toolpath(
     shared_ptr<RoutingMill> mill, const size_t trace_index, bool mirror, const double tool_diameter,
     const double overlap_width,
-    const multi_polygon_type_fp& already_milled_shrunk,
-    const path_finding::PathFindingSurface& path_finding_surface) const {
+    const polygon_index::EdgeIndex& already_milled_shrunk,
+    const path_finding::PathFindingSurface& path_finding_surface,
+    const optional<stage_recorder::Record>& shared_record) const {
     // This is by how much we will grow each trace if extra passes are needed.
     coordinate_type_fp diameter = tool_diameter;
 
@@ -797,9 +920,30 @@ vector<pair<linestring_type_fp, bool>> Surface_vectorial::get_single_toolpath(
       current_trace.emplace(vectorial_surface->first.at(trace_index));
     }
     const auto& current_voronoi = trace_index < voronoi.size() ? voronoi[trace_index] : thermal_holes[trace_index - voronoi.size()];
+    const bool use_layer_offsets = uses_layer_offsets(mill);
+    if (shared_record) {
+      auto single_toolpath_record = record(RecordStage::SINGLE_TOOLPATH, mill);
+      single_toolpath_record.refer_to(*shared_record)
+          .number("mirror", mirror).number("tool_diameter", tool_diameter)
+          .number("overlap_width", overlap_width)
+          .geometry("already_milled", already_milled_shrunk.polygons())
+          .geometry("cell", multi_polygon_type_fp{current_voronoi})
+          .number("voronoi_cell", trace_index < voronoi.size());
+      if (current_trace) {
+        single_toolpath_record.geometry("trace", multi_polygon_type_fp{*current_trace});
+      }
+      if (use_layer_offsets) {
+        // Where the trace is in the shared layer.
+        single_toolpath_record.number("trace_index", trace_index);
+      }
+      single_toolpath_record.save();
+    }
+    // Recording isn't timed.
+    const stats::Timer timer(name + " single toolpath microseconds");
     const vector<multi_polygon_type_fp> polygons =
         offset_polygon(current_trace, current_voronoi,
-                       diameter, overlap, extra_passes + 1, do_voronoi, mill->offset);
+                       diameter, overlap, extra_passes + 1, do_voronoi, mill->offset,
+                       use_layer_offsets, isolator ? isolator->draft_resolution : 0);
 
     // Find if a distance between two points should be milled or retract, move
     // fast, and plunge.  Milling is chosen if it's faster and also the path is
@@ -879,6 +1023,12 @@ vector<pair<linestring_type_fp, bool>> Surface_vectorial::final_path_finder(
     const std::shared_ptr<RoutingMill>& mill,
     const path_finding::PathFindingSurface& path_finding_surface,
     const vector<pair<linestring_type_fp, bool>>& paths) const {
+  if (stage_recorder::recording(RecordStage::PATH_FINDING)) {
+    record(RecordStage::PATH_FINDING, mill).path_finding_surface(path_finding_surface)
+        .paths("paths", paths).save();
+  }
+  // Recording isn't timed.
+  const stats::Timer timer(name + " path finding microseconds");
   // Find all the connectable endpoints.  A connection can only be
   // made if the direction suits it.  connections is the list of
   // possible connections to make.  It is a tuple of (distance between
@@ -950,9 +1100,127 @@ vector<pair<linestring_type_fp, bool>> Surface_vectorial::final_path_finder(
   return new_paths;
 }
 
+// Count the vertices of each toolpath and of the combined toolpath.
+void Surface_vectorial::record_toolpath_stats(const vector<pair<linestring_type_fp, bool>>& toolpath,
+                                              const multi_linestring_type_fp& combined_toolpath) const {
+  if (!stats::enabled()) {
+    return;
+  }
+  for (const auto& ls_and_allow_reversal : toolpath) {
+    stats::add(name + " toolpath vertices", ls_and_allow_reversal.first.size());
+  }
+  stats::add(name + " final toolpath vertices", bg::num_points(combined_toolpath));
+}
+
+// Everything that the toolpath depends on: the layer, the mask and only the
+// options that are used to make the toolpath.  The feeds, speeds and depths
+// are among them because path finding and backtracking use them to estimate
+// the milling time.
+disk_cache::Key Surface_vectorial::toolpath_key(
+    const shared_ptr<RoutingMill>& mill, bool mirror, bool ymirror, bool whole_layer) const {
+  disk_cache::Key key(whole_layer ? "toolpath" : "trace", disk_cache::TOOLPATH_VERSION);
+  if (whole_layer) {
+    key.add(vectorial_surface->first);
+    for (const auto& diameter_and_path : vectorial_surface->second) {
+      key.add(diameter_and_path.first).add(diameter_and_path.second);
+    }
+  }
+  if (mask) {
+    key.add(mask->vectorial_surface->first);
+  }
+  key.add(bounding_box).add(tsp_2opt).add(fill).add(mill_feed_direction)
+      .add(invert_gerbers).add(render_paths_to_shapes).add(mirror).add(ymirror)
+      .add(precision::get_max_deviation());
+  key.add(mill->feed).add(mill->vertfeed).add(mill->zsafe).add(mill->zwork).add(mill->tolerance)
+      .add(mill->optimise).add(mill->eulerian_paths).add(mill->path_finding_limit)
+      .add(mill->g0_vertical_speed).add(mill->g0_horizontal_speed).add(mill->backtrack)
+      .add(mill->offset);
+  auto isolator = dynamic_pointer_cast<Isolator>(mill);
+  if (isolator) {
+    key.add("isolator");
+    for (const auto& tool : isolator->tool_diameters_and_overlap_widths) {
+      key.add(tool.first).add(tool.second);
+    }
+    key.add(isolator->extra_passes).add(isolator->voronoi).add(isolator->preserve_thermal_reliefs)
+        .add(isolator->isolation_width).add(isolator->layer_offsets).add(isolator->draft_resolution)
+        .add(isolator->voronoi_tiles).add(isolator->simplify_voronoi);
+  }
+  auto cutter = dynamic_pointer_cast<Cutter>(mill);
+  if (cutter) {
+    key.add("cutter").add(cutter->tool_diameter);
+  }
+  return key;
+}
+
+// Everything that one trace's toolpath depends on, beyond what's in the
+// tool_key: the trace, its voronoi cell, what's already milled and the traces
+// close enough to it to affect path finding.  All the passes are inside the
+// box around the cell and the trace's path minimum.
+disk_cache::Key Surface_vectorial::trace_toolpath_key(
+    const disk_cache::Key& tool_key, size_t trace_index,
+    const multi_polygon_type_fp& already_milled_shrunk,
+    const polygon_index::PolygonIndex& traces,
+    coordinate_type_fp tool_diameter, coordinate_type_fp keep_out_distance,
+    bool do_voronoi, coordinate_type_fp offset, coordinate_type_fp tolerance) const {
+  disk_cache::Key key(tool_key);
+  // Moving one trace can change the rounding of the voronoi cells far away
+  // so the shapes are only compared to well within the tolerance.
+  const coordinate_type_fp grid = tolerance / 1000;
+  const bool is_trace = trace_index < vectorial_surface->first.size();
+  const auto& cell = is_trace ? voronoi[trace_index] : thermal_holes[trace_index - voronoi.size()];
+  key.add(is_trace).add_snapped(multi_polygon_type_fp{cell}, grid).add_snapped(already_milled_shrunk, grid);
+  auto local_box = bg::return_envelope<box_type_fp>(cell);
+  if (is_trace) {
+    const auto& trace = vectorial_surface->first[trace_index];
+    key.add_snapped(multi_polygon_type_fp{trace}, grid);
+    bg::expand(local_box, bg::return_buffer<box_type_fp>(
+        bg::return_envelope<box_type_fp>(trace), tool_diameter/2 + offset));
+  }
+  if (do_voronoi && offset > 0) {
+    bg::buffer(local_box, local_box, offset);
+  }
+  key.add_snapped(traces.near(bg::return_buffer<box_type_fp>(local_box, keep_out_distance)), grid);
+  return key;
+}
+
 // A bunch of pairs.  Each pair is the tool diameter followed by a vector of paths to mill.
 vector<pair<coordinate_type_fp, multi_linestring_type_fp>> Surface_vectorial::get_toolpath(
     shared_ptr<RoutingMill> mill, bool mirror, bool ymirror) {
+  if (!disk_cache::enabled()) {
+    return make_toolpath(mill, mirror, ymirror);
+  }
+  const auto key = toolpath_key(mill, mirror, ymirror, true);
+  auto cached = disk_cache::load<disk_cache::Toolpaths>(key);
+  if (cached) {
+    return *cached;
+  }
+  const auto toolpath = make_toolpath(mill, mirror, ymirror);
+  if (!found_contentions) {
+    disk_cache::save(key, toolpath);
+  }
+  return toolpath;
+}
+
+// The regions from voronoi tiles are only exact within a strip's width of the
+// traces so the strips must be at least as wide as the farthest isolation
+// pass.  Each pass is at most a tool diameter beyond the previous one.
+unsigned int Surface_vectorial::voronoi_tile_count(const Isolator& isolator) const {
+  if (isolator.voronoi_tiles <= 1) {
+    return 1;
+  }
+  coordinate_type_fp reach = isolator.isolation_width;
+  for (const auto& tool : isolator.tool_diameters_and_overlap_widths) {
+    reach = std::max(reach, (isolator.extra_passes + 1) * tool.first);
+  }
+  reach += isolator.offset + isolator.tolerance;
+  const auto envelope = bg::return_envelope<box_type_fp>(vectorial_surface->first);
+  const auto width = envelope.max_corner().x() - envelope.min_corner().x();
+  const double strips = reach > 0 ? width / reach : isolator.voronoi_tiles;
+  return std::max(1U, static_cast<unsigned int>(std::min<double>(isolator.voronoi_tiles, strips)));
+}
+
+vector<pair<coordinate_type_fp, multi_linestring_type_fp>> Surface_vectorial::make_toolpath(
+    shared_ptr<RoutingMill> mill, bool mirror, bool ymirror) {
   bg::unique(vectorial_surface->first);
   for (auto& diameter_and_path : vectorial_surface->second) {
     bg::unique(diameter_and_path.second);
@@ -961,10 +1229,28 @@ vector<pair<coordinate_type_fp, multi_linestring_type_fp>> Surface_vectorial::ge
     vectorial_surface->first = bounding_box - vectorial_surface->first;
   }
   const auto tolerance = mill->tolerance;
+  auto isolator = dynamic_pointer_cast<Isolator>(mill);
   // Get the voronoi region for each trace.
-  voronoi = Voronoi::build_voronoi(vectorial_surface->first, bounding_box, tolerance);
+  const unsigned int voronoi_tiles = isolator ? voronoi_tile_count(*isolator) : 1;
+  const bool simplify_voronoi = isolator && isolator->simplify_voronoi;
+  disk_cache::Key voronoi_key("voronoi", disk_cache::VORONOI_VERSION);
+  if (disk_cache::enabled()) {
+    voronoi_key.add(vectorial_surface->first).add(bounding_box).add(tolerance)
+        .add(voronoi_tiles).add(simplify_voronoi);
+  }
+  auto cached_voronoi = disk_cache::load<multi_polygon_type_fp>(voronoi_key);
+  if (cached_voronoi) {
+    voronoi.swap(*cached_voronoi);
+  } else {
+    const stats::Timer timer(name + " voronoi microseconds");
+    voronoi = Voronoi::build_voronoi(vectorial_surface->first, bounding_box, tolerance,
+                                     voronoi_tiles, simplify_voronoi);
+    disk_cache::save(voronoi_key, voronoi);
+  }
+  if (stats::enabled()) {
+    stats::add(name + " voronoi vertices", bg::num_points(voronoi));
+  }
 
-  auto isolator = dynamic_pointer_cast<Isolator>(mill);
   if (isolator) {
     if (isolator->preserve_thermal_reliefs && isolator->voronoi) {
       thermal_holes = find_thermal_reliefs(vectorial_surface->first, tolerance);
@@ -974,17 +1260,66 @@ vector<pair<coordinate_type_fp, multi_linestring_type_fp>> Surface_vectorial::ge
     const auto trace_count = vectorial_surface->first.size() + thermal_holes.size(); // Includes thermal holes.
     // One for each trace or thermal hole, including all prior tools.
     vector<multi_polygon_type_fp> already_milled(trace_count);
+    // The area that the tool must not enter, made by buffering the whole
+    // layer at once, and the surface for path finding around it.  They're
+    // only rebuilt when the keep out distance changes,
+    // and then the surface is made from scratch because every ring of the
+    // keep out has moved.
+    multi_polygon_type_fp keep_out;
+    optional<coordinate_type_fp> keep_out_distance;
+    // Each trace's toolpath is cached on its own if it depends only on what's
+    // near the trace.  Offsetting the whole layer doesn't and neither does
+    // path finding that can go around obstacles.  The traces are indexed to
+    // find the ones near each trace for its key.
+    boost::optional<polygon_index::PolygonIndex> nearby_traces;
+    if (disk_cache::enabled() && mill->path_finding_limit <= 1 &&
+        !isolator->layer_offsets && isolator->draft_resolution == 0) {
+      nearby_traces.emplace(vectorial_surface->first);
+    }
+    optional<path_finding::PathFindingSurface> current_path_finding_surface;
     for (size_t tool_index = 0; tool_index < tool_count; tool_index++) {
       const auto& tool = isolator->tool_diameters_and_overlap_widths[tool_index];
       const auto tool_diameter = tool.first;
       vector<vector<pair<linestring_type_fp, bool>>> new_trace_toolpaths(trace_count);
-
-      vector<multi_polygon_type_fp> keep_outs;
-      keep_outs.reserve(vectorial_surface->first.size());
-      for (const auto& poly : vectorial_surface->first) {
-        keep_outs.push_back(bg_helpers::buffer(poly, tool_diameter/2 + isolator->offset));
+      layer_offsets.clear();
+
+      const coordinate_type_fp distance = tool_diameter/2 + isolator->offset;
+      if (!keep_out_distance || distance != *keep_out_distance) {
+        if (isolator->layer_offsets && keep_out_distance && *keep_out_distance >= 0 &&
+            distance > *keep_out_distance) {
+          // Growing the previous keep out is the same as buffering the
+          // traces by the total but the previous one is already merged.
+          keep_out = bg_helpers::buffer(keep_out, distance - *keep_out_distance);
+        } else {
+          keep_out = bg_helpers::buffer(vectorial_surface->first, distance);
+        }
+        keep_out_distance = distance;
+        if (stats::enabled()) {
+          stats::add(name + " keep out vertices", bg::num_points(keep_out));
+        }
+        current_path_finding_surface.emplace(
+            mask ? boost::make_optional(mask->vectorial_surface->first) : boost::none,
+            keep_out, isolator->tolerance, stage_recorder::recording_path_finding_surface());
+      }
+      const auto& path_finding_surface = *current_path_finding_surface;
+      const auto shared_record = single_toolpath_shared_record(mill, path_finding_surface);
+      // The traces' toolpaths for the layer and tool are kept in one file,
+      // which is written again with only this run's traces so that traces
+      // that have changed since don't pile up.
+      boost::optional<disk_cache::Key> tool_key;
+      boost::optional<disk_cache::Key> layer_key;
+      disk_cache::TraceToolpaths cached_trace_toolpaths;
+      disk_cache::TraceToolpaths trace_toolpaths_to_cache;
+      if (nearby_traces) {
+        tool_key.emplace(toolpath_key(mill, mirror, ymirror, false));
+        tool_key->add(tool.first).add(tool.second);
+        layer_key.emplace(*tool_key);
+        layer_key->add(name);
+        auto loaded = disk_cache::load<disk_cache::TraceToolpaths>(*layer_key);
+        if (loaded) {
+          cached_trace_toolpaths.swap(*loaded);
+        }
       }
-      const auto path_finding_surface = path_finding::PathFindingSurface(mask ? boost::make_optional(mask->vectorial_surface->first) : boost::none, sum(keep_outs), isolator->tolerance);
       for (size_t trace_index = 0; trace_index < trace_count; trace_index++) {
         multi_polygon_type_fp already_milled_shrunk =
             bg_helpers::buffer(already_milled[trace_index], -tool_diameter/2 + tolerance);
@@ -1000,8 +1335,25 @@ vector<pair<coordinate_type_fp, multi_linestring_type_fp>> Surface_vectorial::ge
             already_milled_shrunk = already_milled_shrunk + temp;
           }
         }
-        auto new_trace_toolpath = get_single_toolpath(isolator, trace_index, mirror, tool.first, tool.second,
-                                                      already_milled_shrunk, path_finding_surface);
+        boost::optional<uint64_t> trace_digest;
+        if (nearby_traces) {
+          trace_digest = trace_toolpath_key(
+              *tool_key, trace_index, already_milled_shrunk, *nearby_traces, tool_diameter, distance,
+              isolator->voronoi, isolator->offset, tolerance).digest();
+        }
+        const auto cached_trace_toolpath =
+            trace_digest ? cached_trace_toolpaths.find(*trace_digest) : cached_trace_toolpaths.end();
+        disk_cache::TraceToolpath new_trace_toolpath;
+        if (cached_trace_toolpath != cached_trace_toolpaths.end()) {
+          new_trace_toolpath = cached_trace_toolpath->second;
+        } else {
+          new_trace_toolpath = get_single_toolpath(isolator, trace_index, mirror, tool.first, tool.second,
+                                                   polygon_index::EdgeIndex(std::move(already_milled_shrunk)),
+                                                   path_finding_surface, shared_record);
+        }
+        if (trace_digest) {
+          trace_toolpaths_to_cache[*trace_digest] = new_trace_toolpath;
+        }
         if (invert_gerbers) {
           auto shrunk_bounding_box = bg::return_buffer<box_type_fp>(bounding_box, -isolator->tolerance);
           vector<pair<linestring_type_fp, bool>> temp;
@@ -1028,14 +1380,20 @@ vector<pair<coordinate_type_fp, multi_linestring_type_fp>> Surface_vectorial::ge
             bg_helpers::buffer(combined_trace_toolpath, tool_diameter/2);
         already_milled[trace_index] = already_milled[trace_index] + new_trace_toolpath_bufferred;
       }
+      if (layer_key) {
+        disk_cache::save(*layer_key, trace_toolpaths_to_cache);
+      }
 
       const string tool_suffix = tool_count > 1 ? "_" + std::to_string(tool_index) : "";
       write_svgs(tool_suffix, tool_diameter, new_trace_toolpaths, isolator->tolerance, tool_index == tool_count - 1);
       auto new_toolpath = flatten(new_trace_toolpaths);
       multi_linestring_type_fp combined_toolpath = post_process_toolpath(mill, boost::make_optional(&path_finding_surface), new_toolpath);
+      record_toolpath_stats(new_toolpath, combined_toolpath);
       write_svgs("_final" + tool_suffix, tool_diameter, combined_toolpath, isolator->tolerance, tool_index == tool_count - 1);
       results[tool_index] = make_pair(tool_diameter, mirror_toolpath(combined_toolpath, mirror, ymirror));
     }
+    layer_offsets.clear();
+    draft_field.reset();
     // Now process any lines that need drawing.
     for (const auto& diameter_and_paths : vectorial_surface->second) {
       const auto& tool_diameter = diameter_and_paths.first;
@@ -1059,17 +1417,21 @@ vector<pair<coordinate_type_fp, multi_linestring_type_fp>> Surface_vectorial::ge
   }
   auto cutter = dynamic_pointer_cast<Cutter>(mill);
   if (cutter) {
-    const auto path_finding_surface = path_finding::PathFindingSurface(multi_polygon_type_fp(), multi_polygon_type_fp(), cutter->tolerance);
+    const auto path_finding_surface = path_finding::PathFindingSurface(
+        multi_polygon_type_fp(), multi_polygon_type_fp(), cutter->tolerance,
+        stage_recorder::recording_path_finding_surface());
+    const auto shared_record = single_toolpath_shared_record(mill, path_finding_surface);
     const auto trace_count = vectorial_surface->first.size();
     vector<vector<pair<linestring_type_fp, bool>>> new_trace_toolpaths(trace_count);
 
     for (size_t trace_index = 0; trace_index < trace_count; trace_index++) {
-      const auto new_trace_toolpath = get_single_toolpath(cutter, trace_index, mirror, cutter->tool_diameter, 0, multi_polygon_type_fp(), path_finding_surface);
+      const auto new_trace_toolpath = get_single_toolpath(cutter, trace_index, mirror, cutter->tool_diameter, 0, polygon_index::EdgeIndex(), path_finding_surface, shared_record);
       new_trace_toolpaths[trace_index] = new_trace_toolpath;
     }
     write_svgs("", cutter->tool_diameter, new_trace_toolpaths, mill->tolerance, false);
     auto new_toolpath = flatten(new_trace_toolpaths);
     multi_linestring_type_fp combined_toolpath = post_process_toolpath(cutter, boost::none, new_toolpath);
+    record_toolpath_stats(new_toolpath, combined_toolpath);
     return {make_pair(cutter->tool_diameter, mirror_toolpath(combined_toolpath, mirror, ymirror))};
   }
   throw std::logic_error("Can't mill with something other than a Cutter or an Isolator.");
@@ -1077,14 +1439,22 @@ vector<pair<coordinate_type_fp, multi_linestring_type_fp>> Surface_vectorial::ge
 
 void Surface_vectorial::save_debug_image(string message)
 {
-    const string filename = (boost::format("outp%d_%s.svg") % debug_image_index % message).str();
-    svg_writer debug_image(build_filename(outputdir, filename), bounding_box);
-
-    srand(1);
-    debug_image.add(vectorial_surface->first, 1, true);
-    for (const auto& diameter_and_path : vectorial_surface->second) {
-      debug_image.add(diameter_and_path.second, diameter_and_path.first, true);
+    if (!debug_output::images()) {
+      return;
     }
+    const string filename = (boost::format("outp%d_%s.svg") % debug_image_index % message).str();
+    const auto path = build_filename(outputdir, filename);
+    const auto bounding_box = this->bounding_box;
+    const auto surface = *vectorial_surface;
+    debug_output::write([=]() {
+      svg_writer debug_image(path, bounding_box);
+
+      srand(1);
+      debug_image.add(surface.first, 1, true);
+      for (const auto& diameter_and_path : surface.second) {
+        debug_image.add(diameter_and_path.second, diameter_and_path.first, true);
+      }
+    });
 
     ++debug_image_index;
 }
@@ -1095,6 +1465,7 @@ void Surface_vectorial::enable_filling() {
 
 void Surface_vectorial::add_mask(shared_ptr<Surface_vectorial> surface) {
   mask = surface;
+  prepared_mask.reset(new polygon_index::PreparedMask(mask->vectorial_surface->first));
   vectorial_surface->first = vectorial_surface->first & mask->vectorial_surface->first;
   for (auto& diameter_and_path : vectorial_surface->second) {
     diameter_and_path.second = diameter_and_path.second & mask->vectorial_surface->first;
@@ -1124,7 +1495,13 @@ vector<multi_polygon_type_fp> Surface_vectorial::offset_polygon(
     coordinate_type_fp diameter,
     coordinate_type_fp overlap,
     unsigned int steps, bool do_voronoi,
-    coordinate_type_fp offset) const {
+    coordinate_type_fp offset, bool use_layer_offsets,
+    coordinate_type_fp draft_resolution) const {
+  // Offsetting all the traces at once and cropping to the voronoi cell is the
+  // same as offsetting just this trace because, inside its cell, no other trace
+  // is nearer.  Thermal holes and voronoi milling offset the cell itself so
+  // they can't use it.
+  use_layer_offsets = use_layer_offsets && input && !do_voronoi;
   // The polygons to add to the PNG debugging output files.
   // Mask the polygon that we need to mill.
   multi_polygon_type_fp milling_poly{do_voronoi ? voronoi_polygon : *input};  // Milling voronoi or trace?
@@ -1138,15 +1515,41 @@ vector<multi_polygon_type_fp> Surface_vectorial::offset_polygon(
   // doesn't dig into the trace.  We only need this if there is an
   // input which is not the case if this is a thermal hole.
   multi_polygon_type_fp path_minimum;
-  if (input) {
+  if (use_layer_offsets) {
+    // Only ever used inside the voronoi cell.
+    path_minimum = layer_offset(diameter/2 + offset, draft_resolution).intersection(multi_polygon_type_fp{voronoi_polygon});
+  } else if (input) {
     path_minimum = bg_helpers::buffer(*input, diameter/2 + offset);
   }
 
   auto voronoi_shrunk = (bg_helpers::buffer(voronoi_polygon, -diameter/2 + overlap/2) + path_minimum) & voronoi_polygon;
+  // Everything milled for this trace is inside the voronoi cell or the path
+  // minimum so only the mask in that area matters for checking if a pass is
+  // inside the mask, which is most of the time.  Clipping to the mask still
+  // uses the whole mask because boost's results depend slightly on the extent
+  // of the inputs.
+  multi_polygon_type_fp local_mask;
+  if (mask) {
+    auto local_box = bg::return_envelope<box_type_fp>(voronoi_polygon);
+    if (input) {
+      bg::expand(local_box, bg::return_envelope<box_type_fp>(*input));
+    }
+    if (!path_minimum.empty()) {
+      bg::expand(local_box, bg::return_envelope<box_type_fp>(path_minimum));
+    }
+    if (do_voronoi && offset > 0) {
+      // Voronoi passes can grow by the offset beyond the cell.
+      bg::buffer(local_box, local_box, offset);
+    }
+    local_mask = prepared_mask->clip(local_box);
+  }
   // We need to crop the area that we'll mill if it extends outside the PCB's
-  // outline.  This saves time in milling.
+  // outline.  This saves time in milling.  The trace or cell is inside the
+  // local mask's box so, if it's covered by it, there's nothing to crop.
   if (mask) {
-    milling_poly = milling_poly & mask->vectorial_surface->first;
+    if (!bg::covered_by(milling_poly, local_mask)) {
+      milling_poly = milling_poly & mask->vectorial_surface->first;
+    }
   } else {
     // Increase the size of the bounding box to accommodate all milling.
     box_type_fp new_bounding_box;
@@ -1186,15 +1589,20 @@ vector<multi_polygon_type_fp> Surface_vectorial::offset_polygon(
       expand_by = (diameter - overlap) * factor;
     }
 
-    multi_polygon_type_fp buffered_milling_poly = bg_helpers::buffer(milling_poly, expand_by + offset + thermal_offset);
-    if (expand_by + offset != 0) {
+    multi_polygon_type_fp buffered_milling_poly;
+    if (use_layer_offsets && expand_by + offset != 0) {
+      buffered_milling_poly = layer_offset(expand_by + offset, draft_resolution).intersection(voronoi_shrunk);
+    } else {
+      buffered_milling_poly = bg_helpers::buffer(milling_poly, expand_by + offset + thermal_offset);
+    }
+    if (expand_by + offset != 0 && !use_layer_offsets) {
       if (!do_voronoi) {
         buffered_milling_poly = buffered_milling_poly & voronoi_shrunk;
       } else {
         buffered_milling_poly = buffered_milling_poly + path_minimum;
       }
     }
-    if (mask && !bg::covered_by(buffered_milling_poly, mask->vectorial_surface->first)) {
+    if (mask && !bg::covered_by(buffered_milling_poly, local_mask)) {
       // Don't mill outside the mask because that's a waste.
       // But don't mill into the trace itself.
       // And don't mill into other traces.
@@ -1213,3 +1621,39 @@ vector<multi_polygon_type_fp> Surface_vectorial::offset_polygon(
 
   return polygons;
 }
+
+// The whole layer, cropped to the mask if there is one, offset by distance.
+// Computed once for each distance and then reused for all traces.  If
+// draft_resolution is set, the offset is traced from a distance field of the
+// layer with cells of that size.
+const polygon_index::PolygonIndex& Surface_vectorial::layer_offset(coordinate_type_fp distance,
+                                                                   coordinate_type_fp draft_resolution) const {
+  auto found = layer_offsets.find(distance);
+  if (found == layer_offsets.cend()) {
+    multi_polygon_type_fp layer = vectorial_surface->first;
+    if (mask) {
+      layer = layer & mask->vectorial_surface->first;
+    }
+    multi_polygon_type_fp offset_layer;
+    if (draft_resolution > 0 && !layer.empty()) {
+      if (!draft_field || draft_margin < distance + draft_resolution) {
+        // Leave room for the later passes, which are farther out.
+        draft_margin = 2 * (distance + draft_resolution);
+        const bool was_coarser = draft_field && draft_field->resolution() > draft_resolution;
+        draft_field = std::make_unique<distance_field::DistanceField>(
+            layer, bg::return_buffer<box_type_fp>(bg::return_envelope<box_type_fp>(layer), draft_margin),
+            draft_resolution);
+        if (draft_field->resolution() > draft_resolution && !was_coarser) {
+          cerr << "\nWarning: A draft of layer '" << name << "' at the draft-resolution"
+              " would need too much memory, so cells of " << draft_field->resolution()
+              << " inches are used instead.\n";
+        }
+      }
+      offset_layer = draft_field->offset(distance);
+    } else {
+      offset_layer = bg_helpers::buffer(layer, distance);
+    }
+    found = layer_offsets.emplace(distance, offset_layer).first;
+  }
+  return found->second;
+}
@@ -39,6 +39,10 @@
 #include "voronoi.hpp"
 #include "units.hpp"
 #include "path_finding.hpp"
+#include "polygon_index.hpp"
+#include "distance_field.hpp"
+#include "disk_cache.hpp"
+#include "stage_recorder.hpp"
 
 /******************************************************************************/
 /*
@@ -92,15 +96,50 @@ protected:
       vectorial_surface;
   multi_polygon_type_fp voronoi;
   std::vector<polygon_type_fp> thermal_holes;
-
+  // The whole layer offset by each distance, for the current tool.  Only
+  // filled in when the isolator uses layer_offsets.
+  mutable std::map<coordinate_type_fp, polygon_index::PolygonIndex> layer_offsets;
+  // For drafts, the layer offsets are traced from this instead.  It reaches
+  // draft_margin beyond the layer.
+  mutable std::unique_ptr<distance_field::DistanceField> draft_field;
+  mutable coordinate_type_fp draft_margin = 0;
 
   std::shared_ptr<Surface_vectorial> mask;
+  // The mask, prepared for clipping to the area around each trace.
+  std::unique_ptr<polygon_index::PreparedMask> prepared_mask;
+
+  // Set if a toolpath doesn't keep its clearance from the traces.  Those
+  // toolpaths aren't cached so that the warning is printed on every run.
+  mutable bool found_contentions = false;
 
+  // How many strips to build the voronoi regions in.
+  unsigned int voronoi_tile_count(const Isolator& isolator) const;
+  std::vector<std::pair<coordinate_type_fp, multi_linestring_type_fp>> make_toolpath(
+      std::shared_ptr<RoutingMill> mill, bool mirror, bool ymirror);
+  // The key for the whole layer's toolpaths or, if not whole_layer, the part
+  // of the key for each trace's toolpath that is common to all the traces.
+  disk_cache::Key toolpath_key(const std::shared_ptr<RoutingMill>& mill, bool mirror, bool ymirror,
+                               bool whole_layer) const;
+  disk_cache::Key trace_toolpath_key(const disk_cache::Key& tool_key, size_t trace_index,
+                                     const multi_polygon_type_fp& already_milled_shrunk,
+                                     const polygon_index::PolygonIndex& traces,
+                                     coordinate_type_fp tool_diameter, coordinate_type_fp keep_out_distance,
+                                     bool do_voronoi, coordinate_type_fp offset,
+                                     coordinate_type_fp tolerance) const;
+  // A new record for the stage with the settings of this surface and the mill.
+  stage_recorder::Record record(RecordStage::RecordStage stage,
+                                const std::shared_ptr<RoutingMill>& mill) const;
+  boost::optional<stage_recorder::Record> single_toolpath_shared_record(
+      const std::shared_ptr<RoutingMill>& mill,
+      const path_finding::PathFindingSurface& path_finding_surface) const;
+  // Whether the passes are cut from offsets of the whole layer.
+  static bool uses_layer_offsets(const std::shared_ptr<RoutingMill>& mill);
   std::vector<std::pair<linestring_type_fp, bool>> get_single_toolpath(
       std::shared_ptr<RoutingMill> mill, const size_t trace_index, bool mirror, const double tool_diameter,
       const double overlap_width,
-      const multi_polygon_type_fp& already_milled,
-      const path_finding::PathFindingSurface& path_finding_surface) const;
+      const polygon_index::EdgeIndex& already_milled,
+      const path_finding::PathFindingSurface& path_finding_surface,
+      const boost::optional<stage_recorder::Record>& shared_record) const;
   PathFinder make_path_finder(
       std::shared_ptr<RoutingMill> mill,
       const path_finding::PathFindingSurface& path_finding_surface) const;
@@ -117,11 +156,16 @@ protected:
       coordinate_type_fp diameter,
       coordinate_type_fp overlap,
       unsigned int steps, bool do_voronoi,
-      coordinate_type_fp offset) const;
+      coordinate_type_fp offset, bool use_layer_offsets,
+      coordinate_type_fp draft_resolution) const;
+  const polygon_index::PolygonIndex& layer_offset(coordinate_type_fp distance,
+                                                  coordinate_type_fp draft_resolution) const;
   multi_linestring_type_fp post_process_toolpath(
       const std::shared_ptr<RoutingMill>& mill,
       const boost::optional<const path_finding::PathFindingSurface*>& path_finding_surface,
       std::vector<std::pair<linestring_type_fp, bool>> toolpath) const;
+  void record_toolpath_stats(const std::vector<std::pair<linestring_type_fp, bool>>& toolpath,
+                             const multi_linestring_type_fp& combined_toolpath) const;
   void write_svgs(const std::string& tool_suffix, coordinate_type_fp tool_diameter,
                   const std::vector<std::vector<std::pair<linestring_type_fp, bool>>>& new_trace_toolpaths,
                   coordinate_type_fp tolerance, bool find_contentions) const;
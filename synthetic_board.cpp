@@ -0,0 +1,370 @@
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <sys/stat.h>
+#include <sys/types.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+#include "common.hpp"
+#include "synthetic_board.hpp"
+
+namespace synthetic_board {
+
+using std::runtime_error;
+using std::string;
+using std::vector;
+
+// Everything is on a grid with 0.1 inch pitch, written in nanometres.
+static const long long PITCH = 2540000;
+// The board is this many steps of the grid bigger than the traces and pads on
+// each side.
+static const int MARGIN = 2;
+
+// A point on the grid, or a step on it.
+struct Point {
+  int x;
+  int y;
+  bool operator<(const Point& other) const {
+    return std::make_pair(x, y) < std::make_pair(other.x, other.y);
+  }
+  Point operator+(const Point& other) const { return {x + other.x, y + other.y}; }
+  Point operator-(const Point& other) const { return {x - other.x, y - other.y}; }
+  Point operator*(int scale) const { return {x * scale, y * scale}; }
+  // Turned a quarter counterclockwise.
+  Point left() const { return {-y, x}; }
+};
+
+static const Point AXES[] = {{1, 0}, {0, 1}, {-1, 0}, {0, -1}};
+static const Point DIRECTIONS[] = {{1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1}};
+
+// Just the numbers from mt19937 are used because it's the same in every
+// standard library, unlike the distributions.
+class Random {
+ public:
+  explicit Random(uint32_t seed) : generator(seed) {}
+  // From 0 to n - 1.
+  int below(int n) { return generator() % n; }
+  bool chance(double probability) { return generator() < probability * 4294967296.0; }
+
+ private:
+  std::mt19937 generator;
+};
+
+// A straight line or a quarter circle around the center.
+struct Segment {
+  Point start;
+  Point end;
+  bool arc;
+  Point center;
+  bool clockwise;
+};
+
+struct Side {
+  vector<vector<Segment>> traces;
+  // The opposite corners of each rectangle.
+  vector<std::pair<Point, Point>> pours;
+};
+
+class Generator {
+ public:
+  explicit Generator(const Parameters& parameters) :
+      parameters(parameters),
+      random(parameters.seed),
+      // Four times as long as the traces, which are about three steps long.
+      size(std::max(8, static_cast<int>(std::ceil(4 * std::sqrt(parameters.traces))))) {}
+
+  int grid_size() const { return size; }
+
+  Side make_side(Summary& summary) {
+    Side side;
+    for (size_t i = 0; i < parameters.traces; i++) {
+      side.traces.push_back(make_trace(summary));
+    }
+    const double target = parameters.pour_fraction * size * size;
+    double area = 0;
+    while (area < target) {
+      const Point extent{2 + random.below(7), 2 + random.below(7)};
+      const Point corner{random.below(size - extent.x + 1), random.below(size - extent.y + 1)};
+      side.pours.emplace_back(corner, corner + extent);
+      area += extent.x * extent.y;
+    }
+    summary.pours += side.pours.size();
+    return side;
+  }
+
+  // The end of every trace and some other points.
+  std::set<Point> make_pads(const vector<Side>& sides) {
+    std::set<Point> pads;
+    for (const auto& side : sides) {
+      for (const auto& trace : side.traces) {
+        pads.insert(trace.front().start);
+        pads.insert(trace.back().end);
+      }
+    }
+    for (int x = 0; x <= size; x++) {
+      for (int y = 0; y <= size; y++) {
+        if (random.chance(parameters.pad_density)) {
+          pads.insert({x, y});
+        }
+      }
+    }
+    return pads;
+  }
+
+  // Holes in pads picked at random, and anywhere if there aren't enough pads.
+  vector<Point> make_holes(const std::set<Point>& pads) {
+    vector<Point> holes(pads.cbegin(), pads.cend());
+    const size_t from_pads = std::min(parameters.holes, holes.size());
+    for (size_t i = 0; i < from_pads; i++) {
+      std::swap(holes[i], holes[i + random.below(holes.size() - i)]);
+    }
+    holes.resize(from_pads);
+    while (holes.size() < parameters.holes) {
+      holes.push_back(random_point());
+    }
+    return holes;
+  }
+
+ private:
+  bool inside(const Point& p) const {
+    return p.x >= 0 && p.y >= 0 && p.x <= size && p.y <= size;
+  }
+
+  Point random_point() {
+    return {random.below(size + 1), random.below(size + 1)};
+  }
+
+  vector<Segment> make_trace(Summary& summary) {
+    vector<Segment> trace;
+    Point start = random_point();
+    const int segments = 1 + random.below(4);
+    while (trace.size() < size_t(segments)) {
+      if (random.chance(parameters.arc_fraction)) {
+        const int radius = 1 + random.below(2);
+        const Point center = start + AXES[random.below(4)] * radius;
+        const Point to_start = start - center;
+        const Point counterclockwise = center + to_start.left();
+        const Point clockwise = center - to_start.left();
+        if (inside(counterclockwise) || inside(clockwise)) {
+          const bool is_clockwise = !inside(counterclockwise);
+          trace.push_back({start, is_clockwise ? clockwise : counterclockwise, true, center, is_clockwise});
+          summary.arcs++;
+          start = trace.back().end;
+          continue;
+        }
+      }
+      const Point step = DIRECTIONS[random.below(8)] * (1 + random.below(4));
+      // The grid is at least twice as big as the longest step so one of these
+      // fits.
+      const Point end = inside(start + step) ? start + step : start - step;
+      trace.push_back({start, end, false, {0, 0}, false});
+      start = end;
+    }
+    summary.segments += trace.size();
+    return trace;
+  }
+
+  const Parameters& parameters;
+  Random random;
+  const int size;
+};
+
+static long long nanometres(int grid) {
+  return (grid + MARGIN) * PITCH;
+}
+
+static string millimetres(long long nanometres) {
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(6) << nanometres / 1e6;
+  return out.str();
+}
+
+static string xy(const Point& p) {
+  std::ostringstream out;
+  out << "X" << nanometres(p.x) << "Y" << nanometres(p.y);
+  return out.str();
+}
+
+static void write_file(const string& filename, const string& contents) {
+  std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+  out << contents;
+  out.close();
+  if (!out) {
+    throw runtime_error("Can't write " + filename);
+  }
+}
+
+static const string HEADER = "%FSLAX46Y46*%\n%MOMM*%\n";
+
+static void draw_traces(std::ostream& out, const Side& side, int aperture) {
+  out << "D" << aperture << "*\n";
+  for (const auto& trace : side.traces) {
+    out << xy(trace.front().start) << "D02*\n";
+    for (const auto& segment : trace) {
+      if (segment.arc) {
+        const Point offset = segment.center - segment.start;
+        out << (segment.clockwise ? "G02" : "G03") << xy(segment.end)
+            << "I" << offset.x * PITCH << "J" << offset.y * PITCH << "D01*\n";
+      } else {
+        out << "G01" << xy(segment.end) << "D01*\n";
+      }
+    }
+  }
+}
+
+// Most pads are round and some are square.
+static void flash_pads(std::ostream& out, const std::set<Point>& pads, int round, int square) {
+  for (const int aperture : {round, square}) {
+    out << "D" << aperture << "*\n";
+    for (const auto& pad : pads) {
+      if (((pad.x + pad.y) % 5 == 0) == (aperture == square)) {
+        out << xy(pad) << "D03*\n";
+      }
+    }
+  }
+}
+
+static string copper(const Parameters& parameters, int board_size, const Side& side,
+                     const std::set<Point>& pads) {
+  std::ostringstream out;
+  out << "G04 Synthetic board made by pcb2gcode, seed " << parameters.seed << "*\n"
+      << HEADER
+      << "%ADD10C,0.300000*%\n%ADD11C,1.700000*%\n%ADD12R,1.700000X1.700000*%\n";
+  const bool pours = !side.pours.empty();
+  if (pours) {
+    // The traces and pads with 0.3mm of clearance around them.
+    out << "%ADD20C,0.900000*%\n%ADD21C,2.300000*%\n%ADD22R,2.300000X2.300000*%\n";
+  }
+  const bool copies = parameters.copies_x > 1 || parameters.copies_y > 1;
+  if (copies) {
+    const string distance = millimetres(board_size * PITCH);
+    out << "%SRX" << parameters.copies_x << "Y" << parameters.copies_y
+        << "I" << distance << "J" << distance << "*%\n";
+  }
+  out << "%LPD*%\nG75*\n";
+  for (const auto& pour : side.pours) {
+    out << "G36*\n" << xy(pour.first) << "D02*\n"
+        << "G01" << xy({pour.second.x, pour.first.y}) << "D01*\n"
+        << "G01" << xy(pour.second) << "D01*\n"
+        << "G01" << xy({pour.first.x, pour.second.y}) << "D01*\n"
+        << "G01" << xy(pour.first) << "D01*\n"
+        << "G37*\n";
+  }
+  if (pours) {
+    out << "%LPC*%\n";
+    draw_traces(out, side, 20);
+    flash_pads(out, pads, 21, 22);
+    out << "%LPD*%\n";
+  }
+  draw_traces(out, side, 10);
+  flash_pads(out, pads, 11, 12);
+  if (copies) {
+    out << "%SR*%\n";
+  }
+  out << "M02*\n";
+  return out.str();
+}
+
+// Around all the copies.
+static string outline(const Parameters& parameters, int board_size) {
+  const long long width = parameters.copies_x * board_size * PITCH;
+  const long long height = parameters.copies_y * board_size * PITCH;
+  std::ostringstream out;
+  out << "G04 Synthetic board made by pcb2gcode, seed " << parameters.seed << "*\n"
+      << HEADER << "%ADD10C,0.150000*%\nD10*\n"
+      << "X0Y0D02*\n"
+      << "G01X" << width << "Y0D01*\n"
+      << "G01X" << width << "Y" << height << "D01*\n"
+      << "G01X0Y" << height << "D01*\n"
+      << "G01X0Y0D01*\n"
+      << "M02*\n";
+  return out.str();
+}
+
+// Every third hole is bigger.  There's no step and repeat in Excellon so
+// each copy is written out.
+static string drill(const Parameters& parameters, int board_size, const vector<Point>& holes) {
+  std::ostringstream out;
+  out << "M48\n;Synthetic board made by pcb2gcode, seed " << parameters.seed << "\n"
+      << "FMAT,2\nMETRIC,TZ\nT1C0.800\nT2C1.000\n%\nG90\nG05\n";
+  out << std::fixed << std::setprecision(3);
+  for (const int tool : {1, 2}) {
+    out << "T" << tool << "\n";
+    for (unsigned int copy_x = 0; copy_x < parameters.copies_x; copy_x++) {
+      for (unsigned int copy_y = 0; copy_y < parameters.copies_y; copy_y++) {
+        for (size_t i = 0; i < holes.size(); i++) {
+          if ((i % 3 == 0) == (tool == 2)) {
+            out << "X" << (nanometres(holes[i].x) + copy_x * board_size * PITCH) / 1e6
+                << "Y" << (nanometres(holes[i].y) + copy_y * board_size * PITCH) / 1e6 << "\n";
+          }
+        }
+      }
+    }
+  }
+  out << "T0\nM30\n";
+  return out.str();
+}
+
+static const string MILLPROJECT =
+    "front=front.gbr\n"
+    "back=back.gbr\n"
+    "outline=outline.gbr\n"
+    "drill=drill.drl\n"
+    "metric=true\n"
+    "metricoutput=true\n"
+    "mirror-axis=0\n"
+    "zsafe=2\n"
+    "zchange=10\n"
+    "zwork=-0.05\n"
+    "mill-feed=600\n"
+    "mill-speed=10000\n"
+    "offset=0.1\n"
+    "zdrill=-2\n"
+    "drill-feed=300\n"
+    "drill-speed=10000\n"
+    "zcut=-1.7\n"
+    "cut-feed=300\n"
+    "cut-infeed=1\n"
+    "cut-speed=10000\n"
+    "cutter-diameter=2\n"
+    "fill-outline=true\n";
+
+Summary write(const string& directory, const Parameters& parameters) {
+  if (parameters.copies_x == 0 || parameters.copies_y == 0) {
+    throw runtime_error("A synthetic board needs at least one copy in each direction");
+  }
+#ifdef _WIN32
+  const int result = _mkdir(directory.c_str());
+#else
+  const int result = mkdir(directory.c_str(), 0777);
+#endif
+  if (result != 0 && errno != EEXIST) {
+    throw runtime_error("Can't make the directory " + directory + " for a synthetic board");
+  }
+  Summary summary;
+  Generator generator(parameters);
+  const vector<Side> sides{generator.make_side(summary), generator.make_side(summary)};
+  const auto pads = generator.make_pads(sides);
+  const auto holes = generator.make_holes(pads);
+  summary.pads = pads.size();
+  summary.holes = holes.size();
+  const int board_size = generator.grid_size() + 2 * MARGIN;
+  write_file(build_filename(directory, "front.gbr"), copper(parameters, board_size, sides[0], pads));
+  write_file(build_filename(directory, "back.gbr"), copper(parameters, board_size, sides[1], pads));
+  write_file(build_filename(directory, "outline.gbr"), outline(parameters, board_size));
+  write_file(build_filename(directory, "drill.drl"), drill(parameters, board_size, holes));
+  write_file(build_filename(directory, "millproject"), MILLPROJECT);
+  return summary;
+}
+
+} // namespace synthetic_board
@@ -0,0 +1,52 @@
+#ifndef SYNTHETIC_BOARD_HPP
+#define SYNTHETIC_BOARD_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace synthetic_board {
+
+// Made up boards of any size for benchmarking, because the example boards
+// are small.  The same parameters always make the same files.  The board is
+// a square grid with 0.1 inch pitch and everything is on the grid, like a
+// through-hole board.  It gets bigger with the number of traces so that the
+// density stays the same.
+struct Parameters {
+  // The traces on each side.  Each is a few segments long with a pad at each
+  // end.
+  size_t traces = 100;
+  // The fraction of the points on the grid that have a pad, apart from the
+  // ends of the traces.
+  double pad_density = 0.1;
+  // The fraction of the board covered with copper pours on each side.  The
+  // pours are cleared around the traces and pads.
+  double pour_fraction = 0;
+  // The fraction of the segments of the traces that are arcs.
+  double arc_fraction = 0.1;
+  // The number of copies of the board in each direction, made with step and
+  // repeat in the gerber files.
+  unsigned int copies_x = 1;
+  unsigned int copies_y = 1;
+  // The holes in each copy, on the pads as long as there are enough pads.
+  size_t holes = 50;
+  uint32_t seed = 1;
+};
+
+// What was made, in each copy of the board.
+struct Summary {
+  size_t pads = 0;  // On each side.
+  size_t segments = 0;  // On both sides, including the arcs.
+  size_t arcs = 0;
+  size_t pours = 0;
+  size_t holes = 0;
+};
+
+// Writes front.gbr, back.gbr, outline.gbr, drill.drl and a millproject that
+// uses them to the directory, which is made if it doesn't exist.  Throws
+// std::runtime_error if the files can't be written.
+Summary write(const std::string& directory, const Parameters& parameters);
+
+} // namespace synthetic_board
+
+#endif // SYNTHETIC_BOARD_HPP
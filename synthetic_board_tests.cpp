@@ -0,0 +1,113 @@
+#define BOOST_TEST_MODULE synthetic board tests
+#include <boost/test/unit_test.hpp>
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "synthetic_board.hpp"
+
+using std::string;
+using synthetic_board::Parameters;
+using synthetic_board::Summary;
+
+static string read(const string& filename) {
+  std::ifstream in(filename);
+  std::ostringstream contents;
+  contents << in.rdbuf();
+  return contents.str();
+}
+
+static size_t count(const string& text, const string& word) {
+  size_t found = 0;
+  for (size_t i = text.find(word); i != string::npos; i = text.find(word, i + 1)) {
+    found++;
+  }
+  return found;
+}
+
+static size_t count_lines_starting(const string& text, char start) {
+  size_t found = 0;
+  std::istringstream lines(text);
+  string line;
+  while (std::getline(lines, line)) {
+    found += !line.empty() && line[0] == start;
+  }
+  return found;
+}
+
+BOOST_AUTO_TEST_SUITE(synthetic_board_tests)
+
+// The boards go in the current directory.
+BOOST_AUTO_TEST_CASE(same_every_time) {
+  Parameters parameters;
+  parameters.pour_fraction = 0.2;
+  synthetic_board::write("synthetic_board_a", parameters);
+  synthetic_board::write("synthetic_board_b", parameters);
+  for (const string file : {"front.gbr", "back.gbr", "outline.gbr", "drill.drl", "millproject"}) {
+    BOOST_CHECK_EQUAL(read("synthetic_board_a/" + file), read("synthetic_board_b/" + file));
+  }
+  BOOST_CHECK_NE(read("synthetic_board_a/front.gbr"), read("synthetic_board_a/back.gbr"));
+
+  parameters.seed = 2;
+  synthetic_board::write("synthetic_board_b", parameters);
+  BOOST_CHECK_NE(read("synthetic_board_a/front.gbr"), read("synthetic_board_b/front.gbr"));
+}
+
+BOOST_AUTO_TEST_CASE(counts) {
+  Parameters parameters;
+  parameters.traces = 200;
+  parameters.holes = 30;
+  parameters.arc_fraction = 0.5;
+  const Summary summary = synthetic_board::write("synthetic_board_counts", parameters);
+  const string front = read("synthetic_board_counts/front.gbr");
+  const string back = read("synthetic_board_counts/back.gbr");
+  BOOST_CHECK_EQUAL(count(front, "D03*"), summary.pads);
+  BOOST_CHECK_EQUAL(count(back, "D03*"), summary.pads);
+  BOOST_CHECK_EQUAL(count(front + back, "D01*"), summary.segments);
+  BOOST_CHECK_EQUAL(count(front + back, "G02") + count(front + back, "G03"), summary.arcs);
+  BOOST_CHECK_GT(summary.arcs, summary.segments / 4);
+  BOOST_CHECK_LT(summary.arcs, summary.segments);
+  // Each trace has two ends, which may share pads.
+  BOOST_CHECK_GE(summary.pads, 200U);
+  BOOST_CHECK_EQUAL(summary.pours, 0U);
+  BOOST_CHECK_EQUAL(count(front, "G36"), 0U);
+  BOOST_CHECK_EQUAL(count(front, "%SR"), 0U);
+  BOOST_CHECK_EQUAL(summary.holes, 30U);
+  BOOST_CHECK_EQUAL(count_lines_starting(read("synthetic_board_counts/drill.drl"), 'X'), 30U);
+}
+
+BOOST_AUTO_TEST_CASE(pours) {
+  Parameters parameters;
+  parameters.pour_fraction = 0.5;
+  const Summary summary = synthetic_board::write("synthetic_board_pours", parameters);
+  const string front = read("synthetic_board_pours/front.gbr");
+  const string back = read("synthetic_board_pours/back.gbr");
+  BOOST_CHECK_GT(summary.pours, 0U);
+  BOOST_CHECK_EQUAL(count(front + back, "G36*"), summary.pours);
+  BOOST_CHECK_EQUAL(count(front + back, "G37*"), summary.pours);
+  // The traces and pads are cleared from the pours and then drawn.
+  BOOST_CHECK_EQUAL(count(front, "%LPC*%"), 1U);
+  BOOST_CHECK_EQUAL(count(front, "D03*"), 2 * summary.pads);
+}
+
+BOOST_AUTO_TEST_CASE(step_and_repeat) {
+  Parameters parameters;
+  parameters.copies_x = 3;
+  parameters.copies_y = 2;
+  parameters.holes = 10000;
+  const Summary summary = synthetic_board::write("synthetic_board_copies", parameters);
+  const string front = read("synthetic_board_copies/front.gbr");
+  BOOST_CHECK_EQUAL(count(front, "%SRX3Y2I"), 1U);
+  BOOST_CHECK_EQUAL(count(front, "%SR*%"), 1U);
+  BOOST_CHECK_EQUAL(count(front, "D03*"), summary.pads);
+  // More holes than pads.
+  BOOST_CHECK_EQUAL(summary.holes, 10000U);
+  BOOST_CHECK_EQUAL(count_lines_starting(read("synthetic_board_copies/drill.drl"), 'X'), 6 * 10000U);
+
+  parameters.copies_y = 0;
+  BOOST_CHECK_THROW(synthetic_board::write("synthetic_board_copies", parameters), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,15 @@
+#ifndef TEST_SHAPES_HPP
+#define TEST_SHAPES_HPP
+
+#include "geometry.hpp"
+
+// Shapes that the tests are made from.
+
+// The square with its lower left corner at x, y.
+static inline multi_polygon_type_fp square(double x, double y, double size) {
+  multi_polygon_type_fp ret;
+  bg::convert(box_type_fp{{x, y}, {x + size, y + size}}, ret);
+  return ret;
+}
+
+#endif // TEST_SHAPES_HPP
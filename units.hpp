@@ -620,4 +620,75 @@ inline std::istream& operator>>(std::istream& in, MillFeedDirection& millfeeddir
 }
 } // namespace MillFeedDirection
 
+namespace DebugOutput {
+enum DebugOutput {
+  NONE,
+  CONTENTIONS,
+  FULL
+};
+
+inline std::istream& operator>>(std::istream& in, DebugOutput& debug_output) {
+  std::string token(std::istreambuf_iterator<char>(in), {});
+  if (boost::iequals(token, "none")) {
+    debug_output = DebugOutput::NONE;
+  } else if (boost::iequals(token, "contentions")) {
+    debug_output = DebugOutput::CONTENTIONS;
+  } else if (boost::iequals(token, "full")) {
+    debug_output = DebugOutput::FULL;
+  } else {
+    throw boost::program_options::invalid_option_value(token);
+  }
+  return in;
+}
+} // namespace DebugOutput
+
+namespace RecordStage {
+enum RecordStage {
+  NONE,
+  SINGLE_TOOLPATH,
+  PATH_FINDING,
+  POST_PROCESS,
+  TSP
+};
+
+inline std::istream& operator>>(std::istream& in, RecordStage& record_stage) {
+  std::string token(std::istreambuf_iterator<char>(in), {});
+  if (boost::iequals(token, "none")) {
+    record_stage = RecordStage::NONE;
+  } else if (boost::iequals(token, "single-toolpath")) {
+    record_stage = RecordStage::SINGLE_TOOLPATH;
+  } else if (boost::iequals(token, "path-finding")) {
+    record_stage = RecordStage::PATH_FINDING;
+  } else if (boost::iequals(token, "post-process")) {
+    record_stage = RecordStage::POST_PROCESS;
+  } else if (boost::iequals(token, "tsp")) {
+    record_stage = RecordStage::TSP;
+  } else {
+    throw boost::program_options::invalid_option_value(token);
+  }
+  return in;
+}
+
+inline std::ostream& operator<<(std::ostream& out, const RecordStage& record_stage) {
+  switch (record_stage) {
+    case NONE:
+      out << "none";
+      break;
+    case SINGLE_TOOLPATH:
+      out << "single-toolpath";
+      break;
+    case PATH_FINDING:
+      out << "path-finding";
+      break;
+    case POST_PROCESS:
+      out << "post-process";
+      break;
+    case TSP:
+      out << "tsp";
+      break;
+  }
+  return out;
+}
+} // namespace RecordStage
+
 #endif // UNITS_HPP
@@ -114,4 +114,12 @@ BOOST_AUTO_TEST_CASE(parse_MillFeedDirection) {
   BOOST_CHECK_THROW(parse_unit<MillFeedDirection::MillFeedDirection>("all"), po::validation_error);
 }
 
+BOOST_AUTO_TEST_CASE(parse_DebugOutput) {
+  BOOST_CHECK_EQUAL(parse_unit<DebugOutput::DebugOutput>("none"), DebugOutput::NONE);
+  BOOST_CHECK_EQUAL(parse_unit<DebugOutput::DebugOutput>("contentions"), DebugOutput::CONTENTIONS);
+  BOOST_CHECK_EQUAL(parse_unit<DebugOutput::DebugOutput>("Full"), DebugOutput::FULL);
+
+  BOOST_CHECK_THROW(parse_unit<DebugOutput::DebugOutput>("some"), po::validation_error);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
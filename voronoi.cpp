@@ -21,9 +21,13 @@
 
 #include "voronoi.hpp"
 #include "voronoi_visual_utils.hpp"
+#include "parallel.hpp"
+
+#include <boost/geometry/index/rtree.hpp>
 #include <list>
 #include <map>
 #include <algorithm>
+#include <limits>
 using std::list;
 using std::map;
 
@@ -33,9 +37,25 @@ using std::vector;
 // For use when we have to convert from float to long and back.
 const double SCALE = 1000000.0;
 
+// Build the diagram with the builder's own coordinate type, which must be
+// able to hold all the segments.
+template <typename builder_type>
+static void construct_voronoi(const vector<segment_type_p>& segments, voronoi_diagram_type* voronoi_diagram) {
+    typedef typename builder_type::int_type int_type;
+    builder_type voronoi_builder;
+    for (const auto& segment : segments) {
+        voronoi_builder.insert_segment(static_cast<int_type>(segment.low().x()),
+                                       static_cast<int_type>(segment.low().y()),
+                                       static_cast<int_type>(segment.high().x()),
+                                       static_cast<int_type>(segment.high().y()));
+    }
+    voronoi_builder.construct(voronoi_diagram);
+}
+
 multi_polygon_type_fp Voronoi::build_voronoi(
     const multi_polygon_type_fp& input,
-    const box_type_fp& mask_bounding_box, coordinate_type_fp max_dist) {
+    const box_type_fp& mask_bounding_box, coordinate_type_fp max_dist,
+    unsigned int tiles, bool simplify) {
   // We need to scale all the inputs and call the integer version.
   multi_polygon_type_fp scaled_input;
   bg::transform(input, scaled_input,
@@ -52,7 +72,7 @@ multi_polygon_type_fp Voronoi::build_voronoi(
   box_type voronoi_bounding_box;
   bg::convert(scaled_mask_bounding_box, voronoi_bounding_box);
 
-  const multi_polygon_type_fp scaled_voronoi = build_voronoi(voronoi_input, voronoi_bounding_box, max_dist * SCALE);
+  const multi_polygon_type_fp scaled_voronoi = build_voronoi(voronoi_input, voronoi_bounding_box, max_dist * SCALE, tiles, simplify);
   // Scale the result back down.
   multi_polygon_type_fp voronoi;
   bg::transform(scaled_voronoi, voronoi,
@@ -63,10 +83,17 @@ multi_polygon_type_fp Voronoi::build_voronoi(
 
 multi_polygon_type_fp Voronoi::build_voronoi(
     const multi_polygon_type& input,
-    const box_type& mask_bounding_box, coordinate_type max_dist) {
+    const box_type& mask_bounding_box, coordinate_type max_dist,
+    unsigned int tiles, bool simplify) {
     if (input.empty()) {
         return multi_polygon_type_fp();
     }
+    if (simplify && max_dist > 0) {
+        return build_voronoi(simplify_input(input, max_dist), mask_bounding_box, max_dist, tiles);
+    }
+    if (tiles > 1 && input.size() > tiles) {
+        return build_voronoi_tiled(input, mask_bounding_box, max_dist, tiles);
+    }
 
     // Bounding_box is a box that is big enough to hold all milling.
     box_type_fp bounding_box = bg::return_envelope<box_type_fp>(input);
@@ -98,10 +125,17 @@ multi_polygon_type_fp Voronoi::build_voronoi(
     bg::convert(bounding_box, bounding_box_ring);
     copy_ring(bounding_box_ring, segments);
 
-    voronoi_builder_type voronoi_builder;
-    boost::polygon::insert(segments.begin(), segments.end(), &voronoi_builder);
     voronoi_diagram_type voronoi_diagram;
-    voronoi_builder.construct(&voronoi_diagram);
+    // The bounding box surrounds all the segments.
+    const auto& outer_box = bg::return_envelope<box_type>(bounding_box_ring);
+    if (outer_box.min_corner().x() >= std::numeric_limits<int32_t>::min() &&
+        outer_box.min_corner().y() >= std::numeric_limits<int32_t>::min() &&
+        outer_box.max_corner().x() <= std::numeric_limits<int32_t>::max() &&
+        outer_box.max_corner().y() <= std::numeric_limits<int32_t>::max()) {
+        construct_voronoi<voronoi_builder_32_type>(segments, &voronoi_diagram);
+    } else {
+        construct_voronoi<voronoi_builder_type>(segments, &voronoi_diagram);
+    }
 
     // The output polygons which are voronoi shapes.  The outputs
     // match the inputs in number and position but the number of inner
@@ -168,6 +202,115 @@ multi_polygon_type_fp Voronoi::build_voronoi(
     return output;
 }
 
+// Each polygon simplified by tolerance, unless it is within 2*tolerance of
+// another polygon.  No point of a simplified polygon's boundary moves by more
+// than tolerance so each original polygon is still closer to its own
+// simplified polygon than to any of the others.  Polygons that would become
+// invalid are left as they are.
+multi_polygon_type Voronoi::simplify_input(const multi_polygon_type& input, coordinate_type tolerance) {
+    vector<std::pair<box_type, size_t>> envelopes;
+    envelopes.reserve(input.size());
+    for (size_t i = 0; i < input.size(); i++) {
+        envelopes.emplace_back(bg::return_envelope<box_type>(input[i]), i);
+    }
+    const bg::index::rtree<std::pair<box_type, size_t>, bg::index::rstar<16>> index(envelopes);
+    const auto clearance = 2 * tolerance;
+
+    multi_polygon_type output = input;
+    parallel::for_ranges(input.size(), parallel::hardware_threads(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            box_type nearby = envelopes[i].first;
+            nearby.min_corner().x(nearby.min_corner().x() - clearance);
+            nearby.min_corner().y(nearby.min_corner().y() - clearance);
+            nearby.max_corner().x(nearby.max_corner().x() + clearance);
+            nearby.max_corner().y(nearby.max_corner().y() + clearance);
+            bool crowded = false;
+            for (auto it = index.qbegin(bg::index::intersects(nearby)); it != index.qend() && !crowded; it++) {
+                crowded = it->second != i && bg::distance(input[i], input[it->second]) <= clearance;
+            }
+            if (crowded) {
+                continue;
+            }
+            polygon_type simplified;
+            bg::simplify(input[i], simplified, tolerance);
+            bool valid = simplified.outer().size() >= 4 &&
+                         simplified.inners().size() == input[i].inners().size();
+            for (const auto& inner : simplified.inners()) {
+                valid = valid && inner.size() >= 4;
+            }
+            if (valid && bg::is_valid(simplified)) {
+                output[i] = std::move(simplified);
+            }
+        }
+    });
+    return output;
+}
+
+multi_polygon_type_fp Voronoi::build_voronoi_tiled(
+    const multi_polygon_type& input,
+    const box_type& mask_bounding_box, coordinate_type max_dist,
+    unsigned int tiles) {
+    // All the tiles get the same bounding box so that the regions far away
+    // are cut off in the same place.
+    box_type bounding_box = bg::return_envelope<box_type>(input);
+    const auto min_x = bounding_box.min_corner().x();
+    const double strip_width = double(bounding_box.max_corner().x() - min_x) / tiles;
+    bg::expand(bounding_box, mask_bounding_box);
+
+    // Each polygon belongs to the strip with the middle of its envelope.
+    vector<box_type> envelopes;
+    envelopes.reserve(input.size());
+    vector<unsigned int> strips;
+    strips.reserve(input.size());
+    for (const auto& polygon : input) {
+        envelopes.push_back(bg::return_envelope<box_type>(polygon));
+        const double middle = (envelopes.back().min_corner().x() + envelopes.back().max_corner().x()) / 2.0;
+        strips.push_back(std::min(tiles - 1, static_cast<unsigned int>(std::max(0.0, (middle - min_x) / strip_width))));
+    }
+
+    if (!(strip_width > 0)) {
+        return build_voronoi(input, bounding_box, max_dist);
+    }
+
+    // Each strip needs all the polygons within two strips' widths of its own.
+    // Then any point within a strip's width of one of its polygons is at
+    // least a strip's width from the polygons left out, so none of those can
+    // be nearer.
+    vector<double> lows(tiles, std::numeric_limits<double>::infinity());
+    vector<double> highs(tiles, -std::numeric_limits<double>::infinity());
+    for (size_t i = 0; i < input.size(); i++) {
+        lows[strips[i]] = std::min(lows[strips[i]], envelopes[i].min_corner().x() - 2 * strip_width);
+        highs[strips[i]] = std::max(highs[strips[i]], envelopes[i].max_corner().x() + 2 * strip_width);
+    }
+
+    multi_polygon_type_fp output;
+    output.resize(input.size());
+    parallel::for_ranges(tiles, std::min(tiles, parallel::hardware_threads()), [&](size_t begin, size_t end) {
+        for (size_t strip = begin; strip < end; strip++) {
+            const double low = lows[strip];
+            const double high = highs[strip];
+            if (low > high) {
+                continue;  // No polygons in this strip.
+            }
+            multi_polygon_type tile_input;
+            vector<size_t> tile_indices;
+            for (size_t i = 0; i < input.size(); i++) {
+                if (envelopes[i].max_corner().x() >= low && envelopes[i].min_corner().x() <= high) {
+                    tile_input.push_back(input[i]);
+                    tile_indices.push_back(i);
+                }
+            }
+            const auto tile_output = build_voronoi(tile_input, bounding_box, max_dist);
+            for (size_t i = 0; i < tile_indices.size(); i++) {
+                if (strips[tile_indices[i]] == strip) {
+                    output[tile_indices[i]] = tile_output[i];
+                }
+            }
+        }
+    });
+    return output;
+}
+
 bool Voronoi::same_poly(const edge_type& edge0, const edge_type& edge1, const std::vector<size_t>& segments_to_poly) {
     return (std::upper_bound(segments_to_poly.cbegin(), segments_to_poly.cend(), edge0.cell()->source_index()) ==
             std::upper_bound(segments_to_poly.cbegin(), segments_to_poly.cend(), edge1.cell()->source_index()));
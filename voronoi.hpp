@@ -46,6 +46,8 @@ struct voronoi_ctype_traits<int64_t> {
 } } }
 
 typedef boost::polygon::voronoi_builder<coordinate_type> voronoi_builder_type;
+// Much faster than the above but only for inputs that fit in 32 bits.
+typedef boost::polygon::voronoi_builder<int32_t> voronoi_builder_32_type;
 typedef boost::polygon::voronoi_diagram<coordinate_type_fp> voronoi_diagram_type;
 
 typedef voronoi_diagram_type::cell_type cell_type;
@@ -70,15 +72,38 @@ public:
      * each output might not match those of the corresponding input.  max_dist
      * is the maximum error for interpolating parabolic curves into discrete
      * linestrings.  Smaller means more accurate and more points.
+     *
+     * If the input and the margin around it fit in 32-bit coordinates, the
+     * diagram is built with 32-bit arithmetic, which is much faster.  The
+     * result is the same either way.
+     *
+     * If tiles is more than 1, the input is split into that many vertical
+     * strips and the regions for the polygons in each strip are built in
+     * parallel, each from only the polygons within two strips' widths of
+     * them.  The regions are the same as without tiles wherever they are
+     * within a strip's width of their polygons.  Farther away the regions
+     * might overlap or leave gaps, so their edges can't be milled.
+     *
+     * If simplify is true, the polygons are first simplified by max_dist,
+     * which leaves fewer segments for building the diagram.  Only polygons
+     * more than 2*max_dist from all the others are simplified so each input
+     * polygon is still entirely inside its own region.
      */
   static multi_polygon_type_fp build_voronoi(
       const multi_polygon_type& input,
-      const box_type& bounding_box, coordinate_type max_dist);
+      const box_type& bounding_box, coordinate_type max_dist,
+      unsigned int tiles = 1, bool simplify = false);
   static multi_polygon_type_fp build_voronoi(
       const multi_polygon_type_fp& input,
-      const box_type_fp& bounding_box, coordinate_type_fp max_dist);
+      const box_type_fp& bounding_box, coordinate_type_fp max_dist,
+      unsigned int tiles = 1, bool simplify = false);
 
 protected:
+    static multi_polygon_type simplify_input(const multi_polygon_type& input, coordinate_type tolerance);
+    static multi_polygon_type_fp build_voronoi_tiled(
+        const multi_polygon_type& input,
+        const box_type& bounding_box, coordinate_type max_dist,
+        unsigned int tiles);
     static linestring_type_fp edge_to_linestring(const edge_type& edge, const std::vector<segment_type_p>& segments, const box_type_fp& bounding_box, coordinate_type max_dist);
     static void copy_ring(const ring_type& ring, std::vector<segment_type_p> &segments);
     static point_type_p retrieve_point(const cell_type& cell, const std::vector<segment_type_p> &segments);
@@ -90,4 +90,113 @@ BOOST_AUTO_TEST_CASE(almost_square_with_hole) {
   BOOST_CHECK(result[1].inners().size() == 0);
 }
 
+BOOST_AUTO_TEST_CASE(tiles) {
+  multi_polygon_type mp;
+  for (int x = 0; x < 10; x++) {
+    for (int y = 0; y < 10; y++) {
+      polygon_type new_poly;
+      // Uneven spacing so that the cells aren't all the same.
+      bg::convert(box_type{{x * 30 + y, y * 30 + x * x}, {x * 30 + y + 10, y * 30 + x * x + 10}}, new_poly);
+      mp.push_back(new_poly);
+    }
+  }
+  box_type bounding_box;
+  bg::envelope(mp, bounding_box);
+  const auto& expected = Voronoi::build_voronoi(mp, bounding_box, 10);
+  const auto& result = Voronoi::build_voronoi(mp, bounding_box, 10, 4);
+  BOOST_REQUIRE_EQUAL(result.size(), mp.size());
+  // Near the squares, the regions are the same.
+  box_type_fp board{{-5, -5}, {300, 370}};
+  for (size_t i = 0; i < mp.size(); i++) {
+    multi_polygon_type_fp expected_near;
+    bg::intersection(expected[i], board, expected_near);
+    multi_polygon_type_fp result_near;
+    bg::intersection(result[i], board, result_near);
+    BOOST_CHECK_CLOSE(bg::area(result_near), bg::area(expected_near), 1e-6);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(tiles_far_apart) {
+  // The strips are about 100 wide.  The second square is in the next strip
+  // but less than a strip's width from the first one.
+  multi_polygon_type mp;
+  for (int x : {0, 150, 250, 300, 400}) {
+    polygon_type new_poly;
+    bg::convert(box_type{{x, 0}, {x + 2, 2}}, new_poly);
+    mp.push_back(new_poly);
+  }
+  const box_type bounding_box{{0, -200}, {402, 200}};
+  const auto& expected = Voronoi::build_voronoi(mp, bounding_box, 1);
+  const auto& result = Voronoi::build_voronoi(mp, bounding_box, 1, 4);
+  BOOST_REQUIRE_EQUAL(result.size(), mp.size());
+  for (size_t i = 0; i < mp.size(); i++) {
+    const double x = bg::return_envelope<box_type>(mp[i]).min_corner().x();
+    const box_type_fp near{{x - 100, -100}, {x + 102, 102}};
+    multi_polygon_type_fp expected_near;
+    bg::intersection(expected[i], near, expected_near);
+    multi_polygon_type_fp result_near;
+    bg::intersection(result[i], near, result_near);
+    BOOST_CHECK_CLOSE(bg::area(result_near), bg::area(expected_near), 1e-6);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(simplify) {
+  multi_polygon_type mp;
+  // Round pads with many points.
+  for (int x = 0; x < 5; x++) {
+    polygon_type new_poly;
+    for (int i = 0; i < 500; i++) {
+      double angle = -2 * M_PI * i / 500;
+      new_poly.outer().push_back(point_type(x * 3000 + 1000 * cos(angle), 1000 * sin(angle)));
+    }
+    new_poly.outer().push_back(new_poly.outer().front());
+    mp.push_back(new_poly);
+  }
+  // Too close to the last pad to be simplified.
+  polygon_type close_poly;
+  bg::read_wkt("POLYGON((13005 -100, 13005 100, 13100 100, 13100 -100, 13005 -100))", close_poly);
+  mp.push_back(close_poly);
+  box_type bounding_box;
+  bg::envelope(mp, bounding_box);
+  const auto& exact = Voronoi::build_voronoi(mp, bounding_box, 10);
+  const auto& result = Voronoi::build_voronoi(mp, bounding_box, 10, 1, true);
+  BOOST_REQUIRE_EQUAL(result.size(), mp.size());
+  BOOST_CHECK_LT(bg::num_points(result), bg::num_points(exact));
+  for (size_t i = 0; i < mp.size(); i++) {
+    multi_polygon_type_fp input;
+    bg::convert(mp[i], input);
+    BOOST_CHECK(bg::covered_by(input, result[i]));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(wide_coordinates) {
+  multi_polygon_type mp;
+  polygon_type new_poly;
+  bg::read_wkt("POLYGON((0 0, 0 100, 100 100, 100 0, 0 0),(50 20, 80 50, 50 80, 20 50, 50 20))", new_poly);
+  mp.push_back(new_poly);
+  bg::read_wkt("POLYGON((45 45, 45 55, 55 55, 55 45, 45 45))", new_poly);
+  mp.push_back(new_poly);
+  bg::read_wkt("POLYGON((120 10, 130 90, 140 10, 120 10))", new_poly);
+  mp.push_back(new_poly);
+  box_type bounding_box;
+  bg::envelope(mp, bounding_box);
+  const auto& narrow = Voronoi::build_voronoi(mp, bounding_box, 10);
+
+  // Too far out for 32-bit coordinates.
+  const coordinate_type shift = coordinate_type(1) << 33;
+  multi_polygon_type shifted_mp;
+  bg::transform(mp, shifted_mp, bg::strategy::transform::translate_transformer<coordinate_type, 2, 2>(shift, shift));
+  box_type shifted_bounding_box;
+  bg::envelope(shifted_mp, shifted_bounding_box);
+  multi_polygon_type_fp wide;
+  bg::transform(Voronoi::build_voronoi(shifted_mp, shifted_bounding_box, 10), wide,
+                bg::strategy::transform::translate_transformer<coordinate_type_fp, 2, 2>(-shift, -shift));
+
+  BOOST_REQUIRE_EQUAL(wide.size(), narrow.size());
+  for (size_t i = 0; i < narrow.size(); i++) {
+    BOOST_CHECK_EQUAL(bg::num_points(wide[i]), bg::num_points(narrow[i]));
+    BOOST_CHECK_CLOSE(bg::area(wide[i]), bg::area(narrow[i]), 1e-3);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -1,11 +1,16 @@
 #include "geometry.hpp"
+#include "geometry_file.hpp"
 
+#include <iostream>
+#include <stdexcept>
 #include <string>
 using std::string;
 
 #include <boost/format.hpp>
 
-int main() {
+// Draws the WKT geometry on each line of stdin, or the geometry in each of
+// the geometry files named on the command line, as SVG on stdout.
+int main(int argc, char* argv[]) {
   box_type_fp bounding_box;
   bg::envelope(point_type_fp(0,0), bounding_box);
   bg::expand(bounding_box, point_type_fp(14,14));
@@ -19,38 +24,54 @@ int main() {
       str(boost::format("viewBox=\"0 0 %1% %2%\"") % viewBox_width % viewBox_height);
 
   bg::svg_mapper<point_type_fp> mapper(std::cout, viewBox_width, viewBox_height, svg_dimensions);
-  char buffer[1024*64];
-  std::cin.getline(buffer, 1024*64);
-  while (buffer[0] != 0) {
-    if (strncmp(buffer, "MULTILINESTRING", 15) == 0) {
+  const string line_style =
+      "stroke:rgb(0,0,0);stroke-width:10;fill:none;"
+      "stroke-opacity:0.3;stroke-linecap:round;stroke-linejoin:round;";
+  const string polygon_style =
+      "stroke:rgb(0,0,0);stroke-width:10;fill:red;"
+      "stroke-opacity:1;stroke-linecap:round;stroke-linejoin:round;";
+  if (argc > 1) {
+    for (int i = 1; i < argc; i++) {
+      try {
+        const geometry_file::Reader reader(argv[i]);
+        if (reader.kind() == geometry_file::Kind::MULTI_POLYGON) {
+          const auto mp = reader.multi_polygon();
+          mapper.add(mp);
+          mapper.map(mp, polygon_style);
+        } else {
+          const auto mls = reader.multi_linestring();
+          mapper.add(mls);
+          mapper.map(mls, line_style);
+        }
+      } catch (const std::runtime_error& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+      }
+    }
+    return 0;
+  }
+  string buffer;
+  while (std::getline(std::cin, buffer) && !buffer.empty()) {
+    if (buffer.compare(0, 15, "MULTILINESTRING") == 0) {
       multi_linestring_type_fp mls;
       bg::read_wkt(buffer, mls);
       mapper.add(mls);
-      mapper.map(mls,
-                 "stroke:rgb(0,0,0);stroke-width:10;fill:none;"
-                 "stroke-opacity:0.3;stroke-linecap:round;stroke-linejoin:round;");
-    } else if (strncmp(buffer, "LINESTRING", 10) == 0) {
+      mapper.map(mls, line_style);
+    } else if (buffer.compare(0, 10, "LINESTRING") == 0) {
       linestring_type_fp ls;
       bg::read_wkt(buffer, ls);
       mapper.add(ls);
-      mapper.map(ls,
-                 "stroke:rgb(0,0,0);stroke-width:10;fill:none;"
-                 "stroke-opacity:0.3;stroke-linecap:round;stroke-linejoin:round;");
-    } else if (strncmp(buffer, "MULTIPOLYGON", 12) == 0) {
+      mapper.map(ls, line_style);
+    } else if (buffer.compare(0, 12, "MULTIPOLYGON") == 0) {
       multi_polygon_type_fp mp;
       bg::read_wkt(buffer, mp);
       mapper.add(mp);
-      mapper.map(mp,
-                 "stroke:rgb(0,0,0);stroke-width:10;fill:red;"
-                 "stroke-opacity:1;stroke-linecap:round;stroke-linejoin:round;");
-    } else if (strncmp(buffer, "POLYGON", 7) == 0) {
+      mapper.map(mp, polygon_style);
+    } else if (buffer.compare(0, 7, "POLYGON") == 0) {
       polygon_type_fp mp;
       bg::read_wkt(buffer, mp);
       mapper.add(mp);
-      mapper.map(mp,
-                 "stroke:rgb(0,0,0);stroke-width:10;fill:red;"
-                 "stroke-opacity:1;stroke-linecap:round;stroke-linejoin:round;");
+      mapper.map(mp, polygon_style);
     }
-    std::cin.getline(buffer, 1024*64);
   }
 }